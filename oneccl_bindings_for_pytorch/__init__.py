@@ -15,14 +15,10 @@ def set_env_default(env, key, value):
 
 from .version import __version__, git_version
 from . import _C as ccl_lib
+from ._C import AllgatherPrefetcher, DeltaBroadcaster, GradBucketScheduler, RecvStream, allgather_matmul, matmul_reduce_scatter, \
+    ThreadRankGroup, reduce_scatter_cast_allgather
 
-if hasattr(torch, 'xpu'):
-    try:
-        # load the CCL/XPU library
-        import ctypes
-        my_c_library = ctypes.cdll.LoadLibrary(os.path.join(cwd, "lib/liboneccl_bindings_for_pytorch_xpu.so"))
-    except OSError as e:
-        print(f"Warning: Cannot load xpu CCL. CCL doesn't work for XPU device due to {e}")
+# The CCL/XPU library is loaded by the first collective on an xpu tensor.
 
 __all__ = []
 __all__ += [name for name in dir(ccl_lib)
@@ -42,3 +38,187 @@ def is_available(tensors):
 
     return True
 
+
+
+_local_group_count = {}
+
+
+def new_local_group(ranks, **kwargs):
+    """Same as torch.distributed.new_group with the ccl backend, for ranks which
+    are all on this node. The communicators of the group are bootstrapped
+    through node-local shared memory instead of round trips to the store."""
+    import hashlib
+    import torch.distributed as dist
+    ranks = sorted(ranks)
+    local_world_size = int(os.environ.get('LOCAL_WORLD_SIZE', os.environ.get('MPI_LOCALNRANKS', 0)))
+    if local_world_size > 0 and len(set(r // local_world_size for r in ranks)) > 1:
+        raise ValueError("new_local_group: ranks {} are not all on the same node".format(ranks))
+
+    group = dist.new_group(ranks, backend='ccl', **kwargs)
+    # every rank creates the groups in the same order, which makes the count
+    # of the groups with the same ranks agree across the processes
+    key = tuple(ranks)
+    count = _local_group_count.get(key, 0)
+    _local_group_count[key] = count + 1
+    if dist.get_rank() in ranks:
+        job = os.environ.get('TORCHELASTIC_RUN_ID', '{}:{}'.format(os.environ.get('MASTER_ADDR', ''),
+                                                                    os.environ.get('MASTER_PORT', '')))
+        name = '{}/{}/{}'.format(job, ','.join(map(str, ranks)), count)
+        group._get_backend(torch.device('cpu'))._set_local_bootstrap(hashlib.sha1(name.encode()).hexdigest())
+    return group
+
+
+def share_communicators(group=None):
+    """Let the ccl process group share its oneCCL communicators with the other
+    groups of the same ranks, in the same order, on which this was called.
+    Must be called on all the ranks of the group before its first collective.
+    The collectives of the groups sharing communicators must be issued in the
+    same order on all the ranks, as if they were a single group."""
+    import torch.distributed as dist
+    pg = group if group is not None else dist.group.WORLD
+    job = os.environ.get('TORCHELASTIC_RUN_ID', '{}:{}'.format(os.environ.get('MASTER_ADDR', ''),
+                                                                os.environ.get('MASTER_PORT', '')))
+    key = '{}/{}'.format(job, ','.join(map(str, dist.get_process_group_ranks(pg))))
+    pg._get_backend(torch.device('cpu'))._set_comm_share_key(key)
+
+
+def abort_process_group(group=None):
+    """Abort the outstanding collectives of a ccl process group, including the
+    hung ones, and destroy it. The process can create a new group afterwards."""
+    import torch.distributed as dist
+    pg = group if group is not None else dist.group.WORLD
+    for device in ('cpu', 'xpu'):
+        try:
+            backend = pg._get_backend(torch.device(device))
+        except RuntimeError:
+            continue
+        if hasattr(backend, '_abort'):
+            backend._abort()
+    dist.destroy_process_group(group)
+
+
+def rebuild_process_group(store, rank, world_size, **kwargs):
+    """Abort the default ccl process group, if any, and create a new one for
+    the new membership from a fresh store, without restarting the process.
+
+    oneCCL cannot cancel a request, so the communicators of every aborted group
+    stay alive until the process exits: each rebuild leaks one set of them."""
+    import torch.distributed as dist
+    if dist.is_initialized():
+        abort_process_group()
+    dist.init_process_group('ccl', store=store, rank=rank, world_size=world_size, **kwargs)
+
+
+def _out_of_place(output, input, group, async_op, issue):
+    import torch.distributed as dist
+    pg = group if group is not None else dist.group.WORLD
+    outputs = list(output) if isinstance(output, (list, tuple)) else [output]
+    inputs = list(input) if isinstance(input, (list, tuple)) else [input]
+    work = issue(pg._get_backend(inputs[0].device), outputs, inputs)
+    if async_op:
+        return work
+    work.wait()
+
+
+def _group_rank(group, rank):
+    import torch.distributed as dist
+    return rank if group is None else dist.get_group_rank(group, rank)
+
+
+def all_reduce_out(output, input, op=None, group=None, async_op=False):
+    """Same as torch.distributed.all_reduce, but the input is left untouched and
+    the result is written into output, of the same shape. output and input may
+    be lists of tensors, which are reduced as one coalesced op. On CPU, the
+    bitwise and fp8 reductions block the calling thread even with async_op."""
+    import torch.distributed as dist
+    opts = dist.AllreduceOptions()
+    opts.reduceOp = op if op is not None else dist.ReduceOp.SUM
+    return _out_of_place(output, input, group, async_op,
+                         lambda backend, outputs, inputs: backend._allreduce_out(outputs, inputs, opts))
+
+
+def reduce_out(output, input, dst, op=None, group=None, async_op=False):
+    """Same as torch.distributed.reduce, but the input is left untouched and the
+    result is written into output on the dst rank. The output of the other ranks
+    is not written."""
+    import torch.distributed as dist
+    opts = dist.ReduceOptions()
+    opts.reduceOp = op if op is not None else dist.ReduceOp.SUM
+    opts.rootRank = _group_rank(group, dst)
+    return _out_of_place(output, input, group, async_op,
+                         lambda backend, outputs, inputs: backend._reduce_out(outputs, inputs, opts))
+
+
+def broadcast_out(output, input, src, group=None, async_op=False):
+    """Same as torch.distributed.broadcast, but the data of the src rank is read
+    from input and every rank, src included, receives it into output. input is
+    only read on the src rank."""
+    import torch.distributed as dist
+    opts = dist.BroadcastOptions()
+    opts.rootRank = _group_rank(group, src)
+    return _out_of_place(output, input, group, async_op,
+                         lambda backend, outputs, inputs: backend._broadcast_out(outputs, inputs, opts))
+
+
+def _as_list(tensors):
+    return list(tensors) if isinstance(tensors, (list, tuple)) else [tensors]
+
+
+def ring_exchange(send_buf, recv_buf, direction=1, group=None, async_op=False):
+    """Send send_buf to the next rank of the group and receive recv_buf from the
+    previous one (direction=1), or the other way around (direction=-1), as a
+    single operation. send_buf and recv_buf may be lists of tensors, e.g. the K
+    and V blocks of ring attention. With direction=0, both directions run
+    concurrently: send_buf is a pair (to_next, to_prev) and recv_buf a pair
+    (from_prev, from_next)."""
+    import torch.distributed as dist
+    if direction == 1:
+        args = (_as_list(send_buf), _as_list(recv_buf), [], [])
+    elif direction == -1:
+        args = ([], [], _as_list(send_buf), _as_list(recv_buf))
+    elif direction == 0:
+        args = (_as_list(send_buf[0]), _as_list(recv_buf[0]), _as_list(send_buf[1]), _as_list(recv_buf[1]))
+    else:
+        raise ValueError("ring_exchange: direction must be 1, -1 or 0, got {}".format(direction))
+    pg = group if group is not None else dist.group.WORLD
+    device = (args[0] or args[2])[0].device
+    work = pg._get_backend(device)._ring_exchange(*args)
+    if async_op:
+        return work
+    work.wait()
+
+
+class RingExchangeIterator:
+    """Passes a block (a tensor or a list of tensors) around the ring of the
+    ranks of the group and yields (source rank, block) for each of the blocks of
+    the group, starting with the local one. The next block is already in flight
+    into a second buffer while the caller computes on the current one. A yielded
+    block stays valid until the next step; the local block is never written."""
+
+    def __init__(self, block, group=None, direction=1):
+        import torch.distributed as dist
+        if direction not in (1, -1):
+            raise ValueError("RingExchangeIterator: direction must be 1 or -1, got {}".format(direction))
+        self.block = block
+        self.group = group
+        self.direction = direction
+        self.size = dist.get_world_size(group)
+        self.rank = dist.get_rank(group)
+        self.buffers = None
+
+    def __len__(self):
+        return self.size
+
+    def __iter__(self):
+        current = self.block
+        if self.size > 1 and self.buffers is None:
+            self.buffers = [[torch.empty_like(t) for t in _as_list(self.block)] for _ in range(2)]
+        for step in range(self.size):
+            work = None
+            if step + 1 < self.size:
+                received = self.buffers[step % 2]
+                work = ring_exchange(current, received, self.direction, self.group, async_op=True)
+            yield (self.rank - step * self.direction) % self.size, current
+            if work is not None:
+                work.wait()
+                current = received if isinstance(self.block, (list, tuple)) else received[0]
@@ -0,0 +1,274 @@
+"""Two-phase collective I/O for sharded checkpoints.
+
+Instead of every rank writing its own small file, the ranks are split in sets
+of consecutive ranks (one set per node by default) and the first rank of each
+set, its aggregator, receives the shards of the set and writes them to a
+single large file, each shard at an aligned offset. An index describes where
+each tensor of each rank lives. Loading is the reverse: the aggregators read
+large extents and send the shards to their ranks.
+
+The shards move in chunks through a small pool of buffers, and a thread of the
+aggregator writes (or reads) a chunk while the next one is received (or sent).
+"""
+import json
+import os
+import queue
+import threading
+
+import torch
+import torch.distributed as dist
+
+INDEX_FILE = 'index.json'
+DEFAULT_CHUNK_BYTES = 64 << 20
+DEFAULT_ALIGN = 1 << 20
+ENTRY_ALIGN = 8
+
+
+def _flatten(state):
+    entries = []
+    parts = []
+    offset = 0
+    for name, tensor in state.items():
+        tensor = tensor.detach().cpu().contiguous()
+        # each entry starts at a multiple of its element size, so that it can
+        # be viewed as its dtype again
+        align = max(ENTRY_ALIGN, tensor.element_size())
+        pad = -offset % align
+        if pad:
+            parts.append(torch.zeros(pad, dtype=torch.uint8))
+            offset += pad
+        nbytes = tensor.numel() * tensor.element_size()
+        entries.append({'name': name, 'dtype': str(tensor.dtype).replace('torch.', ''),
+                        'shape': list(tensor.shape), 'offset': offset, 'bytes': nbytes})
+        parts.append(tensor.view(-1).view(torch.uint8))
+        offset += nbytes
+    flat = torch.cat(parts) if parts else torch.empty(0, dtype=torch.uint8)
+    return flat, entries
+
+
+def _unflatten(flat, entries):
+    state = {}
+    for entry in entries:
+        data = flat[entry['offset']:entry['offset'] + entry['bytes']]
+        state[entry['name']] = data.view(getattr(torch, entry['dtype'])).view(entry['shape'])
+    return state
+
+
+def _layout(sizes, ranks_per_aggregator, align):
+    """(file, offset, aggregator) of the shard of each rank."""
+    layout = []
+    offset = 0
+    for rank, size in enumerate(sizes):
+        aggregator = rank // ranks_per_aggregator * ranks_per_aggregator
+        if rank == aggregator:
+            offset = 0
+        layout.append(('agg_{:05d}.bin'.format(rank // ranks_per_aggregator), offset, aggregator))
+        offset += (size + align - 1) // align * align
+    return layout
+
+
+def _chunks(nbytes, chunk_bytes):
+    return [(start, min(chunk_bytes, nbytes - start)) for start in range(0, nbytes, chunk_bytes)]
+
+
+def _pwrite(fd, tensor, offset):
+    view = memoryview(tensor.numpy()).cast('B')
+    while len(view):
+        written = os.pwrite(fd, view, offset)
+        view = view[written:]
+        offset += written
+
+
+def _pread(fd, tensor, offset):
+    view = memoryview(tensor.numpy()).cast('B')
+    while len(view):
+        read = os.preadv(fd, [view], offset)
+        if read == 0:
+            raise EOFError("checkpoint file is truncated")
+        view = view[read:]
+        offset += read
+
+
+class _IOThread:
+    """Runs the file I/O of the submitted chunks in the background. The chunks
+    are taken from a pool of `depth` buffers; the writer returns them to the
+    pool itself, the reader hands them over through `done` once read."""
+
+    def __init__(self, fn, chunk_bytes, depth, recycle):
+        self.fn = fn
+        self.recycle = recycle
+        self.pool = queue.Queue()
+        for _ in range(depth):
+            self.pool.put(torch.empty(chunk_bytes, dtype=torch.uint8))
+        self.todo = queue.Queue()
+        self.done = queue.Queue()
+        self.error = None
+        self.thread = threading.Thread(target=self._run, daemon=True)
+        self.thread.start()
+
+    def _run(self):
+        while True:
+            item = self.todo.get()
+            if item is None:
+                return
+            buffer, length, offset, pooled = item
+            try:
+                if self.error is None:
+                    self.fn(buffer[:length], offset)
+            except Exception as e:
+                self.error = e
+            if pooled and self.recycle:
+                self.pool.put(buffer)
+            else:
+                self.done.put((buffer, length))
+
+    def submit(self, buffer, length, offset, pooled=True):
+        self.todo.put((buffer, length, offset, pooled))
+
+    def finish(self):
+        self.todo.put(None)
+        self.thread.join()
+        if self.error is not None:
+            raise self.error
+
+
+def _global_rank(group, rank):
+    return rank if group is None else dist.get_global_rank(group, rank)
+
+
+def _raise_if_any_failed(error, group, what):
+    """Raise on every rank of the group if `error` is set on any of them. The
+    I/O errors of an aggregator are only seen by itself, the other ranks would
+    otherwise wait forever for its data or in the next collective."""
+    ok = torch.tensor([0 if error is not None else 1])
+    dist.all_reduce(ok, op=dist.ReduceOp.MIN, group=group)
+    if error is not None:
+        raise error
+    if not ok.item():
+        raise RuntimeError("an aggregator failed to {} the checkpoint".format(what))
+
+
+def save_sharded(state, path, group=None, ranks_per_aggregator=None, chunk_bytes=DEFAULT_CHUNK_BYTES,
+                 align=DEFAULT_ALIGN, depth=2):
+    """Collectively save the dict of tensors `state` of each rank of the group
+    under the directory `path`. ranks_per_aggregator defaults to the number of
+    ranks per node (LOCAL_WORLD_SIZE or MPI_LOCALNRANKS)."""
+    rank, world_size = dist.get_rank(group), dist.get_world_size(group)
+    if ranks_per_aggregator is None:
+        ranks_per_aggregator = int(os.environ.get('LOCAL_WORLD_SIZE', os.environ.get('MPI_LOCALNRANKS', 1)))
+    flat, entries = _flatten(state)
+    metas = [None] * world_size
+    dist.all_gather_object(metas, {'bytes': flat.numel(), 'entries': entries}, group=group)
+    layout = _layout([meta['bytes'] for meta in metas], ranks_per_aggregator, align)
+    file, offset, aggregator = layout[rank]
+
+    error = None
+    if rank == aggregator:
+        try:
+            os.makedirs(path, exist_ok=True)
+            fd = os.open(os.path.join(path, file), os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o644)
+        except OSError as e:
+            error = e
+    _raise_if_any_failed(error, group, 'write')
+
+    if rank == aggregator:
+        try:
+            writer = _IOThread(lambda chunk, at: _pwrite(fd, chunk, at), chunk_bytes, depth, recycle=True)
+            try:
+                writer.submit(flat, flat.numel(), offset, pooled=False)
+                # after a write error the shards are still received, the members are not left blocked
+                for member in range(rank + 1, min(rank + ranks_per_aggregator, world_size)):
+                    _, member_offset, _ = layout[member]
+                    for start, length in _chunks(metas[member]['bytes'], chunk_bytes):
+                        # blocks while all the buffers are still being written
+                        buffer = writer.pool.get()
+                        dist.recv(buffer[:length], _global_rank(group, member), group=group)
+                        writer.submit(buffer, length, member_offset + start)
+            finally:
+                try:
+                    writer.finish()
+                except OSError as e:
+                    error = e
+        finally:
+            os.close(fd)
+    else:
+        works = [dist.isend(flat[start:start + length], _global_rank(group, aggregator), group=group)
+                 for start, length in _chunks(flat.numel(), chunk_bytes)]
+        for work in works:
+            work.wait()
+
+    # the index only appears once every shard is on disk
+    _raise_if_any_failed(error, group, 'write')
+    if rank == 0:
+        index = {'version': 1, 'world_size': world_size, 'ranks_per_aggregator': ranks_per_aggregator,
+                 'ranks': [{'file': layout[r][0], 'offset': layout[r][1], 'aggregator': layout[r][2],
+                            'bytes': metas[r]['bytes'], 'entries': metas[r]['entries']}
+                           for r in range(world_size)]}
+        os.makedirs(path, exist_ok=True)
+        with open(os.path.join(path, INDEX_FILE + '.tmp'), 'w') as f:
+            json.dump(index, f)
+        os.replace(os.path.join(path, INDEX_FILE + '.tmp'), os.path.join(path, INDEX_FILE))
+    dist.barrier(group)
+
+
+def load_sharded(path, group=None, chunk_bytes=DEFAULT_CHUNK_BYTES, depth=2):
+    """Collectively load the dict of tensors saved by save_sharded for this
+    rank. The group must have the size of the group which saved it."""
+    rank, world_size = dist.get_rank(group), dist.get_world_size(group)
+    with open(os.path.join(path, INDEX_FILE)) as f:
+        index = json.load(f)
+    if index['world_size'] != world_size:
+        raise ValueError("the checkpoint was saved by {} ranks, cannot load it on {}".format(
+            index['world_size'], world_size))
+    mine = index['ranks'][rank]
+    flat = torch.empty(mine['bytes'], dtype=torch.uint8)
+    members = [m for m in range(rank + 1, world_size) if index['ranks'][m]['aggregator'] == rank]
+
+    # a missing or truncated file fails on all the ranks before any data moves
+    error = None
+    fd = None
+    if rank == mine['aggregator']:
+        try:
+            fd = os.open(os.path.join(path, mine['file']), os.O_RDONLY)
+            end = max(index['ranks'][r]['offset'] + index['ranks'][r]['bytes'] for r in [rank] + members)
+            if os.fstat(fd).st_size < end:
+                raise EOFError("checkpoint file {} is truncated".format(mine['file']))
+        except (OSError, EOFError) as e:
+            error = e
+            if fd is not None:
+                os.close(fd)
+    _raise_if_any_failed(error, group, 'read')
+
+    if rank == mine['aggregator']:
+        try:
+            plan = [(m, start, length) for m in members
+                    for start, length in _chunks(index['ranks'][m]['bytes'], chunk_bytes)]
+            reader = _IOThread(lambda chunk, at: _pread(fd, chunk, at), chunk_bytes, depth, recycle=False)
+            try:
+                reader.submit(flat, flat.numel(), mine['offset'], pooled=False)
+                # keep up to `depth` chunks read ahead of the sends, in the order they are sent
+                for m, start, length in plan[:depth]:
+                    reader.submit(reader.pool.get(), length, index['ranks'][m]['offset'] + start)
+                reader.done.get()
+                # after a read error the chunks are still sent, the members are not left blocked
+                for i, (m, start, length) in enumerate(plan):
+                    buffer, _ = reader.done.get()
+                    dist.send(buffer[:length], _global_rank(group, m), group=group)
+                    if i + depth < len(plan):
+                        m, start, length = plan[i + depth]
+                        reader.submit(buffer, length, index['ranks'][m]['offset'] + start)
+            finally:
+                try:
+                    reader.finish()
+                except (OSError, EOFError) as e:
+                    error = e
+        finally:
+            os.close(fd)
+    else:
+        works = [dist.irecv(flat[start:start + length], _global_rank(group, mine['aggregator']), group=group)
+                 for start, length in _chunks(flat.numel(), chunk_bytes)]
+        for work in works:
+            work.wait()
+
+    _raise_if_any_failed(error, group, 'read')
+    return _unflatten(flat, mine['entries'])
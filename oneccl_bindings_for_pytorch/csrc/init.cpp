@@ -41,6 +41,7 @@
 #include <chrono>
 #include <pybind11/chrono.h>
 #include <pybind11/cast.h>
+#include <torch/csrc/jit/python/pybind_utils.h>
 
 #include <torch/version.h>
 #if TORCH_VERSION_MAJOR > 1 || TORCH_VERSION_MINOR >= 13
@@ -60,6 +61,14 @@
 #endif
 
 #include <ProcessGroupCCL.hpp>
+#include <phase_timer.h>
+#include <allgather_prefetcher.h>
+#include <bucket_scheduler.h>
+#include <collective_matmul.h>
+#include <recv_stream.h>
+#include <work_chain.h>
+#include <thread_rank_group.h>
+#include <delta_broadcast.h>
 
 namespace py = pybind11;
 
@@ -121,7 +130,6 @@ using intrusive_ptr_no_gil_destructor_class_ =
 py::class_<T, IntrusivePtrNoGilDestructor<T>>;
 
 TORCH_CCL_CPP_API void torch_ccl_python_init(pybind11::module &m) {
-  c10d::ProcessGroupCCL::cclInitOnce();
   py::object module = py::module::import("torch.distributed");
   py::object register_backend = module.attr("Backend").attr("register_backend");
   #if TORCH_VERSION_MAJOR > 1 
@@ -152,4 +160,343 @@ TORCH_CCL_CPP_API void torch_ccl_python_init(pybind11::module &m) {
     py::arg("size"),
     py::arg("timeout") = std::chrono::milliseconds(10 * 1000));
 
+  processGroupCCL.def(
+    "_set_allgather_quantization",
+    &::c10d::ProcessGroupCCL::setAllgatherQuantization,
+    py::arg("bits"),
+    py::arg("block_size") = 256,
+    py::call_guard<py::gil_scoped_release>());
+
+  processGroupCCL.def(
+    "_set_lossless_compression",
+    &::c10d::ProcessGroupCCL::setLosslessCompression,
+    py::arg("enabled") = true,
+    py::call_guard<py::gil_scoped_release>());
+
+  processGroupCCL.def(
+    "_set_inflight_limits",
+    &::c10d::ProcessGroupCCL::setInflightLimits,
+    py::arg("max_ops") = 0,
+    py::arg("max_bytes") = 0,
+    py::call_guard<py::gil_scoped_release>());
+
+  processGroupCCL.def(
+    "_get_inflight_stats",
+    [](::c10d::ProcessGroupCCL& pg) {
+      auto stats = pg.inflightLimiter_->stats();
+      py::dict res;
+      res["inflight_ops"] = stats.inflightOps;
+      res["inflight_bytes"] = stats.inflightBytes;
+      res["throttled_ops"] = stats.throttledOps;
+      res["throttled_ns"] = stats.throttledNs;
+      res["max_throttled_ns"] = stats.maxThrottledNs;
+      return res;
+    });
+
+  processGroupCCL.def(
+    "_reset_inflight_stats",
+    [](::c10d::ProcessGroupCCL& pg) {
+      pg.inflightLimiter_->resetStats();
+    });
+
+  processGroupCCL.def(
+    "_broadcast_out",
+    &::c10d::ProcessGroupCCL::broadcastOutOfPlace,
+    py::arg("output_tensors"),
+    py::arg("input_tensors"),
+    py::arg("opts") = ::c10d::BroadcastOptions(),
+    py::call_guard<py::gil_scoped_release>());
+
+  processGroupCCL.def(
+    "_allreduce_out",
+    &::c10d::ProcessGroupCCL::allreduceOutOfPlace,
+    py::arg("output_tensors"),
+    py::arg("input_tensors"),
+    py::arg("opts") = ::c10d::AllreduceOptions(),
+    py::call_guard<py::gil_scoped_release>());
+
+  processGroupCCL.def(
+    "_reduce_out",
+    &::c10d::ProcessGroupCCL::reduceOutOfPlace,
+    py::arg("output_tensors"),
+    py::arg("input_tensors"),
+    py::arg("opts") = ::c10d::ReduceOptions(),
+    py::call_guard<py::gil_scoped_release>());
+
+  processGroupCCL.def(
+    "_ring_exchange",
+    &::c10d::ProcessGroupCCL::ringExchange,
+    py::arg("send_to_next"),
+    py::arg("recv_from_prev"),
+    py::arg("send_to_prev"),
+    py::arg("recv_from_next"),
+    py::call_guard<py::gil_scoped_release>());
+
+  processGroupCCL.def(
+    "_set_comm_share_key",
+    &::c10d::ProcessGroupCCL::setCommShareKey,
+    py::arg("key"));
+
+  processGroupCCL.def(
+    "_set_local_bootstrap",
+    &::c10d::ProcessGroupCCL::setLocalBootstrap,
+    py::arg("id"));
+
+  processGroupCCL.def(
+    "_abort",
+    &::c10d::ProcessGroupCCL::abortGroup,
+    py::call_guard<py::gil_scoped_release>());
+
+  processGroupCCL.def(
+    "_is_aborted",
+    &::c10d::ProcessGroupCCL::aborted);
+
+  py::class_<oneccl_bindings_for_pytorch::AllgatherPrefetcher>(m, "AllgatherPrefetcher")
+    .def(py::init([](::c10d::ProcessGroupCCL& pg, std::vector<at::Tensor> shards, int64_t prefetch) {
+           return std::make_unique<oneccl_bindings_for_pytorch::AllgatherPrefetcher>(
+                   c10::intrusive_ptr<::c10d::ProcessGroupCCL>::unsafe_reclaim_from_nonowning(&pg),
+                   std::move(shards),
+                   prefetch);
+         }),
+         py::arg("process_group"),
+         py::arg("shards"),
+         py::arg("prefetch") = 1,
+         py::call_guard<py::gil_scoped_release>())
+    .def("get", &oneccl_bindings_for_pytorch::AllgatherPrefetcher::get,
+         py::arg("index"),
+         py::call_guard<py::gil_scoped_release>())
+    .def("reset", &oneccl_bindings_for_pytorch::AllgatherPrefetcher::reset,
+         py::call_guard<py::gil_scoped_release>())
+    .def("__len__", &oneccl_bindings_for_pytorch::AllgatherPrefetcher::size);
+
+  py::class_<oneccl_bindings_for_pytorch::GradBucketScheduler>(m, "GradBucketScheduler")
+    .def(py::init([](::c10d::ProcessGroupCCL& pg, std::vector<at::Tensor> params, int64_t bucket_cap_mb,
+                     int64_t first_bucket_cap_mb, bool average) {
+           return std::make_unique<oneccl_bindings_for_pytorch::GradBucketScheduler>(
+                   c10::intrusive_ptr<::c10d::ProcessGroupCCL>::unsafe_reclaim_from_nonowning(&pg),
+                   std::move(params),
+                   bucket_cap_mb << 20,
+                   first_bucket_cap_mb << 20,
+                   average);
+         }),
+         py::arg("process_group"),
+         py::arg("params"),
+         py::arg("bucket_cap_mb") = 25,
+         py::arg("first_bucket_cap_mb") = 1,
+         py::arg("average") = true,
+         py::call_guard<py::gil_scoped_release>())
+    .def("mark_ready", &oneccl_bindings_for_pytorch::GradBucketScheduler::markReady,
+         py::arg("index"),
+         py::arg("grad"),
+         py::call_guard<py::gil_scoped_release>())
+    .def("flush", &oneccl_bindings_for_pytorch::GradBucketScheduler::flush,
+         py::call_guard<py::gil_scoped_release>())
+    .def("wait_bucket", &oneccl_bindings_for_pytorch::GradBucketScheduler::waitBucket,
+         py::arg("bucket"),
+         py::call_guard<py::gil_scoped_release>())
+    .def("wait_all", &oneccl_bindings_for_pytorch::GradBucketScheduler::waitAll,
+         py::call_guard<py::gil_scoped_release>())
+    .def("reset", &oneccl_bindings_for_pytorch::GradBucketScheduler::reset,
+         py::call_guard<py::gil_scoped_release>())
+    .def("bucket_of", &oneccl_bindings_for_pytorch::GradBucketScheduler::bucketOf,
+         py::arg("index"))
+    .def_property_readonly("num_buckets", &oneccl_bindings_for_pytorch::GradBucketScheduler::numBuckets);
+
+  py::class_<oneccl_bindings_for_pytorch::RecvStream>(m, "RecvStream")
+    .def(py::init([](::c10d::ProcessGroupCCL& pg, int peer, const at::Tensor& like, int64_t depth, int64_t count) {
+           return std::make_unique<oneccl_bindings_for_pytorch::RecvStream>(
+                   c10::intrusive_ptr<::c10d::ProcessGroupCCL>::unsafe_reclaim_from_nonowning(&pg),
+                   peer,
+                   like.sizes().vec(),
+                   like.options(),
+                   depth,
+                   count);
+         }),
+         py::arg("process_group"),
+         py::arg("peer"),
+         py::arg("like"),
+         py::arg("depth") = 2,
+         py::arg("count") = -1,
+         py::call_guard<py::gil_scoped_release>())
+    .def("next", &oneccl_bindings_for_pytorch::RecvStream::next,
+         py::call_guard<py::gil_scoped_release>())
+    .def("stats", [](const oneccl_bindings_for_pytorch::RecvStream& stream) {
+           auto stats = stream.stats();
+           py::dict res;
+           res["received"] = stats.received;
+           res["ready_on_arrival"] = stats.readyOnArrival;
+           res["sender_ahead"] = stats.senderAhead;
+           res["wait_ns"] = stats.waitNs;
+           return res;
+         })
+    .def("reset_stats", &oneccl_bindings_for_pytorch::RecvStream::resetStats);
+
+  py::class_<oneccl_bindings_for_pytorch::ThreadRankGroup,
+             std::shared_ptr<oneccl_bindings_for_pytorch::ThreadRankGroup>>(m, "ThreadRankGroup")
+    .def(py::init([](int local_size, py::object pg) {
+           c10::intrusive_ptr<::c10d::ProcessGroupCCL> process_group;
+           if (!pg.is_none()) {
+             process_group = c10::intrusive_ptr<::c10d::ProcessGroupCCL>::unsafe_reclaim_from_nonowning(
+                     &pg.cast<::c10d::ProcessGroupCCL&>());
+           }
+           return std::make_shared<oneccl_bindings_for_pytorch::ThreadRankGroup>(local_size, process_group);
+         }),
+         py::arg("local_size"),
+         py::arg("process_group") = py::none())
+    .def_property_readonly("local_size", &oneccl_bindings_for_pytorch::ThreadRankGroup::localSize)
+    .def("size", &oneccl_bindings_for_pytorch::ThreadRankGroup::size)
+    .def("rank", &oneccl_bindings_for_pytorch::ThreadRankGroup::rank, py::arg("local_rank"))
+    .def("bind_numa_node", &oneccl_bindings_for_pytorch::ThreadRankGroup::bindNumaNode,
+         py::arg("local_rank"))
+    .def("allreduce",
+         [](oneccl_bindings_for_pytorch::ThreadRankGroup& group, int local_rank, at::Tensor& tensor,
+            ::c10d::ReduceOp op) {
+           group.allreduce(local_rank, tensor, op);
+         },
+         py::arg("local_rank"),
+         py::arg("tensor"),
+         py::arg("op") = ::c10d::ReduceOp(::c10d::ReduceOp::SUM),
+         py::call_guard<py::gil_scoped_release>())
+    .def("allgather", &oneccl_bindings_for_pytorch::ThreadRankGroup::allgather,
+         py::arg("local_rank"),
+         py::arg("output"),
+         py::arg("input"),
+         py::call_guard<py::gil_scoped_release>())
+    .def("broadcast", &oneccl_bindings_for_pytorch::ThreadRankGroup::broadcast,
+         py::arg("local_rank"),
+         py::arg("tensor"),
+         py::arg("root"),
+         py::call_guard<py::gil_scoped_release>())
+    .def("barrier", &oneccl_bindings_for_pytorch::ThreadRankGroup::barrier,
+         py::arg("local_rank"),
+         py::call_guard<py::gil_scoped_release>());
+
+  py::class_<oneccl_bindings_for_pytorch::DeltaBroadcaster,
+             std::shared_ptr<oneccl_bindings_for_pytorch::DeltaBroadcaster>>(m, "DeltaBroadcaster")
+    .def(py::init([](::c10d::ProcessGroupCCL& pg, std::vector<at::Tensor> tensors, int root, int64_t block_size,
+                     int quant_bits, int64_t refresh_every) {
+           return std::make_shared<oneccl_bindings_for_pytorch::DeltaBroadcaster>(
+                   c10::intrusive_ptr<::c10d::ProcessGroupCCL>::unsafe_reclaim_from_nonowning(&pg),
+                   std::move(tensors), root, block_size, quant_bits, refresh_every);
+         }),
+         py::arg("process_group"),
+         py::arg("tensors"),
+         py::arg("root") = 0,
+         py::arg("block_size") = 16384,
+         py::arg("quant_bits") = 0,
+         py::arg("refresh_every") = 0)
+    .def("broadcast_delta", &oneccl_bindings_for_pytorch::DeltaBroadcaster::broadcast,
+         py::call_guard<py::gil_scoped_release>())
+    .def("stats", [](const oneccl_bindings_for_pytorch::DeltaBroadcaster& broadcaster) {
+           auto stats = broadcaster.stats();
+           py::dict res;
+           res["broadcasts"] = stats.broadcasts;
+           res["full_refreshes"] = stats.fullRefreshes;
+           res["blocks_sent"] = stats.blocksSent;
+           res["bytes_sent"] = stats.bytesSent;
+           res["full_bytes"] = stats.fullBytes;
+           return res;
+         });
+
+  // Timestamps and phase durations of a work issued by a ccl process group.
+  m.def("_get_work_timing", [](::c10d::C10D_Work& work) {
+    auto* ccl_work = dynamic_cast<::c10d::ProcessGroupCCL::AsyncWorkCCL*>(&work);
+    TORCH_CHECK(ccl_work != nullptr, "the work was not issued by a ccl process group");
+    int64_t enqueue = ccl_work->enqueueTimeNs_.load();
+    int64_t start = ccl_work->startTimeNs_.load();
+    int64_t end = ccl_work->endTimeNs_.load();
+    py::dict timing;
+    timing["enqueue_ns"] = enqueue;
+    timing["start_ns"] = start;
+    timing["end_ns"] = end;
+    if (enqueue != 0 && start != 0) {
+      timing["queue_ms"] = (start - enqueue) / 1e6;
+    }
+    if (start != 0 && end != 0) {
+      timing["transfer_ms"] = (end - start) / 1e6;
+    }
+    if (enqueue != 0 && end != 0) {
+      timing["total_ms"] = (end - enqueue) / 1e6;
+    }
+    return timing;
+  }, py::arg("work"));
+
+  m.def("_shared_comms_count", &::c10d::ProcessGroupCCL::sharedCommsCount);
+
+  m.def("allgather_matmul",
+        [](::c10d::ProcessGroupCCL& pg, const at::Tensor& x_shard, const at::Tensor& weight, int64_t chunks) {
+          return oneccl_bindings_for_pytorch::allgather_matmul(
+                  c10::intrusive_ptr<::c10d::ProcessGroupCCL>::unsafe_reclaim_from_nonowning(&pg),
+                  x_shard, weight, chunks);
+        },
+        py::arg("process_group"),
+        py::arg("x_shard"),
+        py::arg("weight"),
+        py::arg("chunks") = 4,
+        py::call_guard<py::gil_scoped_release>());
+
+  m.def("matmul_reduce_scatter",
+        [](::c10d::ProcessGroupCCL& pg, const at::Tensor& x, const at::Tensor& weight, int64_t chunks) {
+          return oneccl_bindings_for_pytorch::matmul_reduce_scatter(
+                  c10::intrusive_ptr<::c10d::ProcessGroupCCL>::unsafe_reclaim_from_nonowning(&pg),
+                  x, weight, chunks);
+        },
+        py::arg("process_group"),
+        py::arg("x"),
+        py::arg("weight"),
+        py::arg("chunks") = 4,
+        py::call_guard<py::gil_scoped_release>());
+
+  // Runs on the progress thread once the reduce-scatter completes, the future
+  // is the only point where Python comes back in.
+  m.def("reduce_scatter_cast_allgather",
+        [](::c10d::ProcessGroupCCL& pg, const at::Tensor& input, py::object dtype) {
+          auto scalar_type = torch::python::detail::py_object_to_dtype(dtype);
+          c10::intrusive_ptr<c10::ivalue::Future> future;
+          {
+            py::gil_scoped_release release;
+            future = oneccl_bindings_for_pytorch::reduce_scatter_cast_allgather(
+                    c10::intrusive_ptr<::c10d::ProcessGroupCCL>::unsafe_reclaim_from_nonowning(&pg),
+                    input, scalar_type);
+          }
+          return std::make_shared<torch::jit::PythonFutureWrapper>(future);
+        },
+        py::arg("process_group"),
+        py::arg("input"),
+        py::arg("dtype"));
+
+  // Allgathers the first output of `first`, issued on the same group, once it
+  // completes: the chain of reduce_scatter_cast_allgather from any first op.
+  m.def("_chain_allgather",
+        [](::c10d::ProcessGroupCCL& pg, ::c10d::C10D_Work& first, const at::Tensor& output) {
+          auto pg_ptr = c10::intrusive_ptr<::c10d::ProcessGroupCCL>::unsafe_reclaim_from_nonowning(&pg);
+          std::vector<oneccl_bindings_for_pytorch::ChainStep> steps;
+          steps.push_back([pg_ptr, output](std::vector<at::Tensor>& outputs) mutable {
+            return pg_ptr->_allgather_base(output, outputs[0], c10d::AllgatherOptions());
+          });
+          c10::intrusive_ptr<c10::ivalue::Future> future;
+          {
+            py::gil_scoped_release release;
+            future = oneccl_bindings_for_pytorch::chain(
+                    pg_ptr, c10::intrusive_ptr<::c10d::C10D_Work>::unsafe_reclaim_from_nonowning(&first),
+                    std::move(steps));
+          }
+          return std::make_shared<torch::jit::PythonFutureWrapper>(future);
+        },
+        py::arg("process_group"),
+        py::arg("first"),
+        py::arg("output"));
+
+  // Per-phase latency breakdown of the collectives, used by tests/bench_binding_overhead.py.
+  m.def("_set_phase_timer_enabled", &oneccl_bindings_for_pytorch::set_phase_timer_enabled,
+        py::arg("enabled"));
+  m.def("_reset_phase_timer", &oneccl_bindings_for_pytorch::reset_phase_timer);
+  m.def("_get_phase_stats", []() {
+    py::dict stats;
+    for (const auto& phase : oneccl_bindings_for_pytorch::get_phase_stats()) {
+      stats[py::str(phase.name)] = py::make_tuple(phase.count, phase.total_ns);
+    }
+    return stats;
+  });
+
 }
@@ -0,0 +1,286 @@
+"""Predict the communication time of a job at another scale or on another
+fabric, on a single machine.
+
+A trace of the collectives of a step is captured from a live run, with any
+number of ranks (record_comm_trace), or loaded from a file. Each op is then
+replayed through a latency/bandwidth (alpha-beta) model of the message
+schedule of the chosen oneCCL algorithm, for the target world size and
+network:
+
+    python -m oneccl_bindings_for_pytorch.simulator trace.json --world-sizes 64,256 \\
+        --ranks-per-node 8 --inter-bandwidth 100Gbps --inter-latency 5us
+
+The model is analytical: it ignores contention, congestion and the overlap of
+concurrent ops, so it is an estimate to compare configurations with.
+"""
+import argparse
+import contextlib
+import json
+import math
+import os
+import time
+
+# oneCCL algorithm selection variables and the algorithms modelled for them.
+ALGORITHMS = {
+    'allreduce': ('CCL_ALLREDUCE', ['ring', 'rabenseifner', 'recursive_doubling', 'double_tree', 'direct',
+                                    'hierarchical']),
+    'allgather': ('CCL_ALLGATHERV', ['ring', 'recursive_doubling', 'naive']),
+    'reduce_scatter': ('CCL_REDUCE_SCATTER', ['ring', 'direct']),
+    'broadcast': ('CCL_BCAST', ['double_tree', 'ring', 'naive']),
+    'reduce': ('CCL_REDUCE', ['tree', 'rabenseifner', 'direct']),
+    'alltoall': ('CCL_ALLTOALL', ['naive', 'scatter']),
+}
+
+
+class Link:
+    """Latency in seconds and bandwidth in bytes per second of one link."""
+
+    def __init__(self, latency, bandwidth):
+        self.latency = latency
+        self.bandwidth = bandwidth
+
+    def time(self, nbytes, messages=1):
+        return messages * self.latency + nbytes / self.bandwidth
+
+
+class Network:
+    """Ranks packed by ranks_per_node on nodes, linked by the intra-node link
+    (shared memory) inside a node and by the inter-node link (the fabric)
+    across nodes. A flat algorithm spanning nodes runs at the pace of the
+    inter-node link."""
+
+    def __init__(self, ranks_per_node, intra, inter):
+        self.ranks_per_node = max(1, ranks_per_node)
+        self.intra = intra
+        self.inter = inter
+
+    def link(self, group_size):
+        return self.intra if group_size <= self.ranks_per_node else self.inter
+
+
+def _log2(p):
+    return math.ceil(math.log2(p)) if p > 1 else 0
+
+
+def collective_time(op, nbytes, p, network, algorithm=None):
+    """Predicted time of one collective. nbytes is the size of the buffer of a
+    rank: the reduced tensor of an allreduce/reduce, the broadcast tensor, the
+    gathered output of an allgather, the input of a reduce-scatter and the send
+    buffer of an alltoall."""
+    if p <= 1:
+        return 0.0
+    link = network.link(p)
+    a, b = link.latency, 1.0 / link.bandwidth
+    n = float(nbytes)
+    algorithm = algorithm or ALGORITHMS.get(op, (None, [None]))[1][0]
+    if op == 'allreduce':
+        if algorithm == 'ring':
+            return 2 * (p - 1) * a + 2 * (p - 1) / p * n * b
+        if algorithm == 'rabenseifner':
+            return 2 * _log2(p) * a + 2 * (p - 1) / p * n * b
+        if algorithm == 'recursive_doubling':
+            return _log2(p) * (a + n * b)
+        if algorithm == 'double_tree':
+            # the two trees each carry half of the data, pipelined
+            return 2 * _log2(p) * a + n * b
+        if algorithm == 'direct':
+            return (p - 1) * a + (p - 1) * n * b
+        if algorithm == 'hierarchical':
+            local = min(p, network.ranks_per_node)
+            nodes = math.ceil(p / local)
+            intra = Network(local, network.intra, network.intra)
+            inter = Network(1, network.inter, network.inter)
+            # reduce-scatter and allgather in the node, allreduce of a slice across the nodes
+            return (collective_time('reduce_scatter', n, local, intra, 'ring') +
+                    collective_time('allreduce', n / local, nodes, inter, 'ring') +
+                    collective_time('allgather', n, local, intra, 'ring'))
+    elif op == 'allgather' or op == 'reduce_scatter':
+        if algorithm in ('ring', None):
+            return (p - 1) * a + (p - 1) / p * n * b
+        if algorithm == 'recursive_doubling':
+            return _log2(p) * a + (p - 1) / p * n * b
+        if algorithm in ('naive', 'direct'):
+            return (p - 1) * (a + n / p * b)
+    elif op == 'broadcast' or op == 'reduce':
+        if algorithm in ('double_tree', 'tree'):
+            return _log2(p) * (a + n * b)
+        if algorithm in ('ring', 'rabenseifner'):
+            # scatter then allgather
+            return (_log2(p) + p - 1) * a + 2 * (p - 1) / p * n * b
+        if algorithm in ('naive', 'direct'):
+            return (p - 1) * (a + n * b)
+    elif op == 'alltoall':
+        if algorithm in ('naive', 'scatter', None):
+            return (p - 1) * (a + n / p * b)
+    elif op in ('send', 'recv'):
+        return a + n * b
+    elif op == 'barrier':
+        return _log2(p) * a
+    raise ValueError("no model for {} with algorithm {}".format(op, algorithm))
+
+
+def parse_bandwidth(s):
+    """'100Gbps', '12.5GB/s', '25e9' (bytes per second)."""
+    s = str(s).strip()
+    units = [('gbps', 1e9 / 8), ('mbps', 1e6 / 8), ('gb/s', 1e9), ('mb/s', 1e6)]
+    for unit, scale in units:
+        if s.lower().endswith(unit):
+            return float(s[:-len(unit)]) * scale
+    return float(s)
+
+
+def parse_latency(s):
+    """'5us', '1.5ms', '2e-6' (seconds)."""
+    s = str(s).strip()
+    for unit, scale in [('ns', 1e-9), ('us', 1e-6), ('ms', 1e-3), ('s', 1.0)]:
+        if s.endswith(unit):
+            return float(s[:-len(unit)]) * scale
+    return float(s)
+
+
+def scale_op(entry, world_size):
+    """The op of a trace entry at another world size. The ops of the whole
+    world scale with it, the ones of subgroups (e.g. tensor parallel) keep their
+    size. The gathered output of an allgather and the input of a reduce-scatter
+    keep their size, as for sharded parameters and gradients."""
+    p = entry['group_size']
+    if p == entry.get('world_size', p):
+        p = world_size
+    return entry['op'], entry['bytes'], p
+
+
+def simulate(trace, world_size, network, algorithms=None):
+    """Returns [(op, bytes, group size, predicted seconds)] for the entries of
+    the trace replayed at world_size."""
+    algorithms = algorithms or {}
+    result = []
+    for entry in trace:
+        op, nbytes, p = scale_op(entry, world_size)
+        result.append((op, nbytes, p, collective_time(op, nbytes, p, network, algorithms.get(op))))
+    return result
+
+
+def default_algorithms():
+    """The algorithms selected by the CCL_* variables of the environment."""
+    selected = {}
+    for op, (env, modelled) in ALGORITHMS.items():
+        value = os.environ.get(env, '').split(':')[0]
+        if value in modelled:
+            selected[op] = value
+    return selected
+
+
+# torch.distributed function: (op, position and name of the argument sized).
+_RECORDED = {
+    'all_reduce': ('allreduce', 0, 'tensor'),
+    'reduce': ('reduce', 0, 'tensor'),
+    'broadcast': ('broadcast', 0, 'tensor'),
+    'all_gather': ('allgather', 0, 'tensor_list'),
+    'all_gather_into_tensor': ('allgather', 0, 'output_tensor'),
+    'reduce_scatter': ('reduce_scatter', 1, 'input_list'),
+    'reduce_scatter_tensor': ('reduce_scatter', 1, 'input'),
+    'all_to_all': ('alltoall', 1, 'input_tensor_list'),
+    'all_to_all_single': ('alltoall', 1, 'input'),
+    'send': ('send', 0, 'tensor'),
+    'isend': ('send', 0, 'tensor'),
+    'recv': ('recv', 0, 'tensor'),
+    'irecv': ('recv', 0, 'tensor'),
+    'barrier': ('barrier', None, None),
+}
+
+
+def _nbytes(args, kwargs, index, name):
+    if index is None:
+        return 0
+    tensors = args[index] if len(args) > index else kwargs[name]
+    if not isinstance(tensors, (list, tuple)):
+        tensors = [tensors]
+    return sum(t.numel() * t.element_size() for t in tensors)
+
+
+@contextlib.contextmanager
+def record_comm_trace(trace):
+    """Appends an entry to the list `trace` for each torch.distributed op issued
+    in the block: the op, the bytes of a rank, the size of its group and the
+    time it was issued at. Works with any number of ranks, even one. The ops
+    are recorded when called through the torch.distributed module."""
+    import torch.distributed as dist
+    originals = {}
+    start = time.perf_counter()
+
+    def wrap(name, op, index, arg_name):
+        original = getattr(dist, name)
+
+        def recorded(*args, **kwargs):
+            group = kwargs.get('group')
+            trace.append({'op': op, 'bytes': _nbytes(args, kwargs, index, arg_name),
+                          'group_size': dist.get_world_size(group), 'world_size': dist.get_world_size(),
+                          'time': time.perf_counter() - start})
+            return original(*args, **kwargs)
+        originals[name] = original
+        setattr(dist, name, recorded)
+
+    for name, (op, index, arg_name) in _RECORDED.items():
+        if hasattr(dist, name):
+            wrap(name, op, index, arg_name)
+    try:
+        yield trace
+    finally:
+        for name, original in originals.items():
+            setattr(dist, name, original)
+
+
+def report(results, out=print):
+    total = 0.0
+    by_op = {}
+    for op, nbytes, p, seconds in results:
+        total += seconds
+        count, time_sum, bytes_sum = by_op.get(op, (0, 0.0, 0))
+        by_op[op] = (count + 1, time_sum + seconds, bytes_sum + nbytes)
+    out('{:>16} {:>8} {:>14} {:>14} {:>8}'.format('op', 'count', 'bytes', 'time(ms)', 'share'))
+    for op, (count, time_sum, bytes_sum) in sorted(by_op.items(), key=lambda kv: -kv[1][1]):
+        out('{:>16} {:>8} {:>14} {:>14.3f} {:>7.1f}%'.format(op, count, bytes_sum, time_sum * 1e3,
+                                                             100.0 * time_sum / total if total else 0.0))
+    out('{:>16} {:>8} {:>14} {:>14.3f}'.format('total', len(results), sum(r[1] for r in results), total * 1e3))
+    return total
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description='Predict the communication time of a captured trace')
+    parser.add_argument('trace', help='json list of {"op", "bytes", "group_size", "world_size"} entries')
+    parser.add_argument('--world-sizes', type=str, default=None,
+                        help='comma separated world sizes, default: the one of the trace')
+    parser.add_argument('--ranks-per-node', type=int, default=1)
+    parser.add_argument('--intra-latency', type=str, default='1us')
+    parser.add_argument('--intra-bandwidth', type=str, default='50GB/s')
+    parser.add_argument('--inter-latency', type=str, default='5us')
+    parser.add_argument('--inter-bandwidth', type=str, default='100Gbps')
+    parser.add_argument('--per-op', action='store_true', help='print the prediction of every op')
+    for op, (env, modelled) in ALGORITHMS.items():
+        parser.add_argument('--' + op.replace('_', '-'), choices=modelled, default=None,
+                            help='algorithm, default: {} or {}'.format(env, modelled[0]))
+    args = parser.parse_args(argv)
+
+    with open(args.trace) as f:
+        trace = json.load(f)
+    network = Network(args.ranks_per_node,
+                      Link(parse_latency(args.intra_latency), parse_bandwidth(args.intra_bandwidth)),
+                      Link(parse_latency(args.inter_latency), parse_bandwidth(args.inter_bandwidth)))
+    algorithms = default_algorithms()
+    for op in ALGORITHMS:
+        if getattr(args, op) is not None:
+            algorithms[op] = getattr(args, op)
+
+    traced_world = max([e.get('world_size', e['group_size']) for e in trace] or [1])
+    world_sizes = [int(s) for s in args.world_sizes.split(',')] if args.world_sizes else [traced_world]
+    for world_size in world_sizes:
+        results = simulate(trace, world_size, network, algorithms)
+        print('\n{} ranks, {} per node, {} ops'.format(world_size, args.ranks_per_node, len(results)))
+        if args.per_op:
+            for op, nbytes, p, seconds in results:
+                print('  {:>16} {:>14} bytes {:>6} ranks {:>12.3f} ms'.format(op, nbytes, p, seconds * 1e3))
+        report(results)
+
+
+if __name__ == '__main__':
+    main()
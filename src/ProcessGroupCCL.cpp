@@ -31,12 +31,15 @@
 
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <map>
+#include <utility>
 #include <ATen/record_function.h>
 #include <ccl_comm_collector.h>
 #include "ProcessGroupCCL.hpp"
 #include "dispatch_stub.h"
 #include "env.h"
+#include "phase_timer.h"
 
 
 namespace c10d
@@ -508,6 +511,8 @@ TORCH_LIBRARY_IMPL(c10d, XPU, m) {
 using oneccl_bindings_for_pytorch::DispatchStub;
 using oneccl_bindings_for_pytorch::call_with_lock;
 using oneccl_bindings_for_pytorch::format_tensors_param;
+using oneccl_bindings_for_pytorch::Phase;
+using oneccl_bindings_for_pytorch::ScopedPhase;
 
 namespace {
 
@@ -533,18 +538,20 @@ c10::intrusive_ptr<c10::ivalue::Future> createFutureAsOutput(
           c10::ListType::create(c10::TensorType::get()));
 }
 
-void returnFutureWithOutput(
-        c10::intrusive_ptr<c10::ivalue::Future>& future,
-        const std::vector<std::vector<at::Tensor>>& outputTensors) {
+c10::IValue futureOutputValue(const std::vector<std::vector<at::Tensor>>& outputTensors) {
   if (outputTensors.size() == 0) {
-    future->markCompleted(c10::IValue(std::vector<at::Tensor>()));
-    return;
+    return c10::IValue(std::vector<at::Tensor>());
   }
   if (outputTensors.size() > 1) {
-    future->markCompleted(c10::IValue(outputTensors));
-    return;
+    return c10::IValue(outputTensors);
   }
-  future->markCompleted(c10::IValue(outputTensors[0]));
+  return c10::IValue(outputTensors[0]);
+}
+
+void returnFutureWithOutput(
+        c10::intrusive_ptr<c10::ivalue::Future>& future,
+        const std::vector<std::vector<at::Tensor>>& outputTensors) {
+  future->markCompleted(futureOutputValue(outputTensors));
 }
 
 bool parseTorchCCLEnvVarFlag(const char* envVarName, bool default_val) {
@@ -612,8 +619,96 @@ ProcessGroupCCL::AsyncWorkCCL::AsyncWorkCCL(std::vector<std::vector<at::Tensor>>
   }
 }
 
+ProcessGroupCCL::AsyncWorkCCL::~AsyncWorkCCL() {
+  releaseInflight();
+}
+
+void ProcessGroupCCL::AsyncWorkCCL::abort() {
+  aborted_ = true;
+}
+
+void ProcessGroupCCL::AsyncWorkCCL::acquireInflight() {
+  if (!inflightLimiter_ || inflightAcquired_) {
+    return;
+  }
+  inflightBytes_ = 0;
+  for (const auto& outputs : outputTensors_) {
+    for (const auto& output : outputs) {
+      inflightBytes_ += output.nbytes();
+    }
+  }
+  inflightLimiter_->acquire(inflightBytes_, !inContinuation());
+  inflightAcquired_ = true;
+}
+
+void ProcessGroupCCL::AsyncWorkCCL::releaseInflight() {
+  if (inflightAcquired_) {
+    inflightAcquired_ = false;
+    inflightLimiter_->release(inflightBytes_);
+  }
+}
+
+void InflightLimiter::setLimits(int64_t maxOps, int64_t maxBytes) {
+  TORCH_CHECK(maxOps >= 0 && maxBytes >= 0, "in-flight limits must not be negative");
+  std::lock_guard<std::mutex> lock(mutex_);
+  maxOps_ = maxOps;
+  maxBytes_ = maxBytes;
+  cv_.notify_all();
+}
+
+void InflightLimiter::acquire(int64_t bytes, bool wait) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto admitted = [&]() {
+    auto maxOps = maxOps_.load();
+    auto maxBytes = maxBytes_.load();
+    return aborted_ || ops_ == 0 ||
+           ((maxOps == 0 || ops_ + 1 <= maxOps) && (maxBytes == 0 || bytes_ + bytes <= maxBytes));
+  };
+  if (wait && !admitted()) {
+    auto start = std::chrono::steady_clock::now();
+    cv_.wait(lock, admitted);
+    auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    throttledOps_++;
+    throttledNs_ += waited;
+    maxThrottledNs_ = std::max(maxThrottledNs_, (int64_t)waited);
+  }
+  TORCH_CHECK(!aborted_, "The process group was aborted");
+  ops_++;
+  bytes_ += bytes;
+}
+
+void InflightLimiter::release(int64_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ops_--;
+    bytes_ -= bytes;
+  }
+  cv_.notify_all();
+}
+
+InflightLimiter::Stats InflightLimiter::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return {ops_, bytes_, throttledOps_, throttledNs_, maxThrottledNs_};
+}
+
+void InflightLimiter::abort() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    aborted_ = true;
+  }
+  cv_.notify_all();
+}
+
+void InflightLimiter::resetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  throttledOps_ = 0;
+  throttledNs_ = 0;
+  maxThrottledNs_ = 0;
+}
+
 c10::intrusive_ptr<c10::ivalue::Future> ProcessGroupCCL::AsyncWorkCCL::getFuture() {
-  return future_;
+  return resultFuture_ ? resultFuture_ : future_;
 }
 
 std::vector<at::Tensor> ProcessGroupCCL::AsyncWorkCCL::result() {
@@ -621,19 +716,133 @@ std::vector<at::Tensor> ProcessGroupCCL::AsyncWorkCCL::result() {
           isCompleted(),
           "Work needs to be completed before calling result(). "
           "Should call wait() before result().");
+  const auto& outputTensors = resultFuture_ ? resultTensors_ : outputTensors_;
   TORCH_CHECK(
-          outputTensors_.size() <= 1,
+          outputTensors.size() <= 1,
           "work result does not support list of lists, use .getFuture() and value()");
-  return outputTensors_.size() == 0 ? std::vector<at::Tensor>()
-                                    : outputTensors_.at(0);
+  return outputTensors.size() == 0 ? std::vector<at::Tensor>()
+                                   : outputTensors.at(0);
+}
+
+void ProcessGroupCCL::AsyncWorkCCL::setResultTensors(const std::vector<at::Tensor>& outputs,
+                                                     const std::vector<at::Tensor>& results) {
+  resultTensors_ = outputTensors_;
+  for (auto& list : resultTensors_) {
+    for (auto& tensor : list) {
+      for (size_t i = 0; i < outputs.size(); ++i) {
+        if (tensor.is_same(outputs[i])) {
+          tensor = results[i];
+          break;
+        }
+      }
+    }
+  }
+  auto resultTensors = resultTensors_;
+  resultFuture_ = future_->then(
+          [resultTensors](c10::ivalue::Future& future) {
+            // Rethrows the error of the work, if any.
+            future.value();
+            return futureOutputValue(resultTensors);
+          },
+          future_->elementType());
+}
+
+int64_t ProcessGroupCCL::AsyncWorkCCL::nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void markOnce(std::atomic<int64_t>& timestamp) {
+  int64_t unset = 0;
+  timestamp.compare_exchange_strong(unset, ProcessGroupCCL::AsyncWorkCCL::nowNs());
+}
+
+void ProcessGroupCCL::AsyncWorkCCL::markStarted() {
+  markOnce(startTimeNs_);
+}
+
+void ProcessGroupCCL::AsyncWorkCCL::markCompleted() {
+  markOnce(endTimeNs_);
+}
+
+#if TORCH_VERSION_MAJOR > 2 || (TORCH_VERSION_MAJOR == 2 && TORCH_VERSION_MINOR >= 1)
+float ProcessGroupCCL::AsyncWorkCCL::getDuration() const {
+  auto start = startTimeNs_.load();
+  auto end = endTimeNs_.load();
+  TORCH_CHECK(start != 0 && end != 0,
+              "getDuration can only be called once the work has completed, call wait() first");
+  return (end - start) / 1e6f;
+}
+#endif
+
+namespace {
+thread_local bool inContinuation_ = false;
+
+// Marks the continuations run by this thread, whether on the progress thread
+// or inline on the caller's, when the work had already completed.
+class ContinuationScope {
+public:
+  ContinuationScope() : outer_(inContinuation_) {
+    inContinuation_ = true;
+  }
+  ~ContinuationScope() {
+    inContinuation_ = outer_;
+  }
+
+private:
+  bool outer_;
+};
+}
+
+bool ProcessGroupCCL::AsyncWorkCCL::inContinuation() {
+  return inContinuation_;
+}
+
+void ProcessGroupCCL::AsyncWorkCCL::addContinuation(Continuation fn) {
+  std::exception_ptr eptr;
+  {
+    std::lock_guard<std::mutex> lock(continuationMutex_);
+    if (!continued_) {
+      continuations_.push_back(std::move(fn));
+      return;
+    }
+    eptr = continuationError_;
+  }
+  ContinuationScope scope;
+  fn(*this, eptr);
+}
+
+void ProcessGroupCCL::AsyncWorkCCL::runContinuations(std::exception_ptr eptr) {
+  std::vector<Continuation> continuations;
+  {
+    std::lock_guard<std::mutex> lock(continuationMutex_);
+    continued_ = true;
+    continuationError_ = eptr;
+    continuations.swap(continuations_);
+  }
+  if (continuations.empty()) {
+    return;
+  }
+  ContinuationScope scope;
+  for (auto& fn : continuations) {
+    // They run on the progress thread, which must go on with the next works.
+    try {
+      fn(*this, eptr);
+    } catch (const std::exception& e) {
+      TORCH_WARN("a continuation of ", debugName, " failed: ", e.what());
+    }
+  }
 }
 
 void ProcessGroupCCL::AsyncWorkCCL::finishAsyncWorkCCLError(std::exception_ptr eptr) {
+  markCompleted();
+  runContinuations(eptr);
   future_->setError(eptr);
   finish(eptr);
 }
 
 void ProcessGroupCCL::AsyncWorkCCL::finishAsyncWorkCCL() {
+  runContinuations(nullptr);
   returnFutureWithOutput(future_, outputTensors_);
   finish();
 }
@@ -675,8 +884,10 @@ ProcessGroupCCL::ProcessGroupCCL(const c10::intrusive_ptr<Store>& store, int ran
 #else
     : ProcessGroup(rank, size), store_(store), timeout(op_time_out),
 #endif
-      ccl_member_(std::make_unique<oneccl_bindings_for_pytorch::CCLCommCollector>())
+      ccl_member_(std::make_shared<oneccl_bindings_for_pytorch::CCLCommCollector>())
 {
+  // Deferred from the import of the module to the first process group.
+  cclInitOnce();
   torch_llm_allreduce_ = parseTorchCCLEnvVarFlag(TORCH_LLM_ALLREDUCE, torch_llm_allreduce_);
   // Hide CCL_SKIP_SCHEDULER/CCL_ENABLE_SYCL_KERNELS/CCL_SYCL_ESIMD by TORCH_LLM_ALLREDUCE
   if (torch_llm_allreduce_) {
@@ -689,6 +900,18 @@ ProcessGroupCCL::ProcessGroupCCL(const c10::intrusive_ptr<Store>& store, int ran
   useSameStream_ = parseTorchCCLEnvVarFlag(CCL_SAME_STREAM, useSameStream_);
   blockingWait_ = parseTorchCCLEnvVarFlag(CCL_BLOCKING_WAIT, blockingWait_);
 
+  int quant_bits = getOneCCLEnvVar(CCL_ALLGATHER_QUANT_BITS);
+  int quant_block = getOneCCLEnvVar(CCL_ALLGATHER_QUANT_BLOCK);
+  setAllgatherQuantization(quant_bits == -1 ? allgatherQuantBits_ : quant_bits,
+                           quant_block == -1 ? allgatherQuantBlockSize_ : quant_block);
+
+  losslessCompression_ = parseTorchCCLEnvVarFlag(CCL_LOSSLESS_COMPRESSION, losslessCompression_);
+
+  int max_inflight_ops = getOneCCLEnvVar(CCL_MAX_INFLIGHT_OPS);
+  int max_inflight_mb = getOneCCLEnvVar(CCL_MAX_INFLIGHT_MB);
+  setInflightLimits(max_inflight_ops == -1 ? 0 : max_inflight_ops,
+                    max_inflight_mb == -1 ? 0 : (int64_t) max_inflight_mb << 20);
+
   // Set these 3 variables to follow oneCCL specs, which is required to enable use drmfd mode of ze exchange mechanism.
   if (!with_mpirun()) {
     // If it's launched by 'torchrun', LOCAL_RANK and LOCAL_WORLD_SIZE were set.
@@ -726,6 +949,70 @@ ProcessGroupCCL::~ProcessGroupCCL()
 {
 }
 
+void ProcessGroupCCL::setAllgatherQuantization(int bits, int64_t blockSize) {
+  TORCH_CHECK(bits == 0 || bits == 4 || bits == 8,
+              "allgather quantization supports 8 or 4 bits (0 to disable), got ", bits);
+  TORCH_CHECK(blockSize > 0, "allgather quantization block size must be positive, got ", blockSize);
+  allgatherQuantBits_ = bits;
+  allgatherQuantBlockSize_ = blockSize;
+}
+
+void ProcessGroupCCL::setLosslessCompression(bool enabled) {
+  losslessCompression_ = enabled;
+}
+
+void ProcessGroupCCL::setInflightLimits(int64_t maxOps, int64_t maxBytes) {
+  inflightLimiter_->setLimits(maxOps, maxBytes);
+}
+
+void ProcessGroupCCL::setLocalBootstrap(const std::string& id) {
+  TORCH_CHECK(!id.empty(), "the local bootstrap id must not be empty");
+  cclMember()->set_local_bootstrap(id, getSize(), timeout);
+}
+
+void ProcessGroupCCL::setCommShareKey(const std::string& key) {
+  TORCH_CHECK(!key.empty(), "the communicator share key must not be empty");
+  cclMember()->set_share_key(key + "|" + std::to_string(getSize()));
+}
+
+size_t ProcessGroupCCL::sharedCommsCount() {
+  return oneccl_bindings_for_pytorch::shared_comms_count();
+}
+
+void ProcessGroupCCL::abortGroup() {
+  groupAborted_->store(true);
+  inflightLimiter_->abort();
+  auto fresh = std::make_shared<oneccl_bindings_for_pytorch::CCLCommCollector>();
+  std::shared_ptr<oneccl_bindings_for_pytorch::CCLCommCollector> aborted;
+  {
+    std::lock_guard<std::mutex> lock(cclMemberMutex_);
+    aborted = std::exchange(ccl_member_, std::move(fresh));
+  }
+  // The groups created later must not pick the aborted communicators.
+  aborted->unshare();
+
+  // The communicators may have requests which never complete, and destroying
+  // them could block. They are kept alive until the process exits: each abort
+  // leaks the communicators of the group, see rebuild_process_group. The
+  // threads still holding them from cclMember() keep a valid pointer.
+  static std::mutex abandonedMutex;
+  static auto* abandoned = new std::vector<std::shared_ptr<oneccl_bindings_for_pytorch::CCLCommCollector>>();
+  std::lock_guard<std::mutex> lock(abandonedMutex);
+  abandoned->push_back(std::move(aborted));
+}
+
+std::shared_ptr<oneccl_bindings_for_pytorch::CCLCommCollector> ProcessGroupCCL::cclMember() const {
+  std::lock_guard<std::mutex> lock(cclMemberMutex_);
+  return ccl_member_;
+}
+
+void ProcessGroupCCL::checkNoChainInFlight() const {
+  TORCH_CHECK(!chainInFlight_.load() || AsyncWorkCCL::inContinuation(),
+              "A chain of ops is in flight on the process group. Its steps are issued on each rank when "
+              "the previous op completes, so the group cannot issue anything else in the same order on "
+              "all the ranks until the chain completes. Run the chains on a dedicated process group.");
+}
+
 void ProcessGroupCCL::startCoalescing() {
     // TODO: GroupStart
     // Currently oneccl dost not support group execution like NCCL, just mark here.
@@ -744,6 +1031,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::broadcast(
     std::vector<at::Tensor>& tensors,
     const BroadcastOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, tensors);
   RECORD_FUNCTION("oneccl_bindings_for_pytorch::broadcast", tensor_param);
@@ -758,6 +1046,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::allreduce(
   std::vector<at::Tensor>& tensors,
   const AllreduceOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, tensors);
   RECORD_FUNCTION("oneccl_bindings_for_pytorch::allreduce", tensor_param);
@@ -770,6 +1059,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::allreduce_coalesced(
     std::vector<at::Tensor>& tensors,
     const AllreduceCoalescedOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, tensors);
   RECORD_FUNCTION("oneccl_bindings_for_pytorch::allreduce_coalesced", tensor_param);
@@ -782,6 +1072,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::reduce(
     std::vector<at::Tensor>& tensors,
     const ReduceOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, tensors);
   RECORD_FUNCTION("oneccl_bindings_for_pytorch::reduce", tensor_param);
@@ -792,11 +1083,56 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::reduce(
 }
 
 
+c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::broadcastOutOfPlace(
+    std::vector<at::Tensor>& outputTensors,
+    std::vector<at::Tensor>& inputTensors,
+    const BroadcastOptions& opts)
+{
+  ScopedPhase phase(Phase::API);
+  std::vector<c10::IValue> tensor_param;
+  format_tensors_param(tensor_param, inputTensors);
+  RECORD_FUNCTION("oneccl_bindings_for_pytorch::broadcast_oop", tensor_param);
+
+  checkRank(opts.rootRank, getSize());
+  auto work = DispatchStub::broadcast_oop(outputTensors, inputTensors, opts, *this);
+  return work;
+}
+
+c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::allreduceOutOfPlace(
+    std::vector<at::Tensor>& outputTensors,
+    std::vector<at::Tensor>& inputTensors,
+    const AllreduceOptions& opts)
+{
+  ScopedPhase phase(Phase::API);
+  std::vector<c10::IValue> tensor_param;
+  format_tensors_param(tensor_param, inputTensors);
+  RECORD_FUNCTION("oneccl_bindings_for_pytorch::allreduce_oop", tensor_param);
+
+  auto work = DispatchStub::allreduce_oop(outputTensors, inputTensors, opts, *this);
+  return work;
+}
+
+c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::reduceOutOfPlace(
+    std::vector<at::Tensor>& outputTensors,
+    std::vector<at::Tensor>& inputTensors,
+    const ReduceOptions& opts)
+{
+  ScopedPhase phase(Phase::API);
+  std::vector<c10::IValue> tensor_param;
+  format_tensors_param(tensor_param, inputTensors);
+  RECORD_FUNCTION("oneccl_bindings_for_pytorch::reduce_oop", tensor_param);
+
+  checkRank(opts.rootRank, getSize());
+  auto work = DispatchStub::reduce_oop(outputTensors, inputTensors, opts, *this);
+  return work;
+}
+
 c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::allgather(
     std::vector<std::vector<at::Tensor>>& outputTensors,
     std::vector<at::Tensor>& inputTensors,
     const AllgatherOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, inputTensors);
   format_tensors_param(tensor_param, outputTensors);
@@ -811,6 +1147,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::_allgather_base(
       at::Tensor& inputTensor,
       const AllgatherOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, inputTensor);
   format_tensors_param(tensor_param, outputTensor);
@@ -832,6 +1169,7 @@ c10::intrusive_ptr<Work> ProcessGroupCCL::allgather_into_tensor_coalesced(
     std::vector<at::Tensor>& inputTensors,
     const AllgatherOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, inputTensors);
   format_tensors_param(tensor_param, outputTensors);
@@ -846,6 +1184,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::gather(
     std::vector<at::Tensor>& inputTensors,
     const GatherOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, inputTensors);
   format_tensors_param(tensor_param, outputTensors);
@@ -860,6 +1199,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::scatter(
     std::vector<std::vector<at::Tensor>>& inputTensors,
     const ScatterOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, inputTensors);
   format_tensors_param(tensor_param, outputTensors);
@@ -874,6 +1214,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::reduce_scatter(
     std::vector<std::vector<at::Tensor>>& inputTensors,
     const ReduceScatterOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, inputTensors);
   format_tensors_param(tensor_param, outputTensors);
@@ -888,6 +1229,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::_reduce_scatter_base(
      at::Tensor& inputTensor,
      const ReduceScatterOptions& opts)
 {
+     ScopedPhase phase(Phase::API);
      std::vector<c10::IValue> tensor_param;
      format_tensors_param(tensor_param, inputTensor);
      format_tensors_param(tensor_param, outputTensor);
@@ -901,6 +1243,7 @@ c10::intrusive_ptr<Work> ProcessGroupCCL::reduce_scatter_tensor_coalesced(
     std::vector<at::Tensor>& inputTensors,
     const ReduceScatterOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, inputTensors);
   format_tensors_param(tensor_param, outputTensors);
@@ -917,6 +1260,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::alltoall_base(
     std::vector<int64_t>& inputSplitSizes,
     const AllToAllOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, inputTensor);
   format_tensors_param(tensor_param, outputTensor);
@@ -931,6 +1275,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::alltoall(
     std::vector<at::Tensor>& inputTensors,
     const AllToAllOptions& opts)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, inputTensors);
   format_tensors_param(tensor_param, outputTensors);
@@ -945,6 +1290,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::send(
     int dstRank,
     int tag)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, tensors);
   RECORD_FUNCTION("oneccl_bindings_for_pytorch::send", tensor_param);
@@ -958,6 +1304,7 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::recv(
     int srcRank,
     int tag)
 {
+  ScopedPhase phase(Phase::API);
   std::vector<c10::IValue> tensor_param;
   format_tensors_param(tensor_param, tensors);
   RECORD_FUNCTION("oneccl_bindings_for_pytorch::recv", tensor_param);
@@ -966,6 +1313,34 @@ c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::recv(
   return work;
 }
 
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> ProcessGroupCCL::prepostRecv(
+    std::vector<at::Tensor>& tensors,
+    int srcRank)
+{
+  ScopedPhase phase(Phase::API);
+  std::vector<c10::IValue> tensor_param;
+  format_tensors_param(tensor_param, tensors);
+  RECORD_FUNCTION("oneccl_bindings_for_pytorch::prepost_recv", tensor_param);
+
+  return DispatchStub::prepost_recv(tensors, srcRank, *this);
+}
+
+c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::ringExchange(
+    std::vector<at::Tensor>& sendToNext,
+    std::vector<at::Tensor>& recvFromPrev,
+    std::vector<at::Tensor>& sendToPrev,
+    std::vector<at::Tensor>& recvFromNext)
+{
+  ScopedPhase phase(Phase::API);
+  std::vector<c10::IValue> tensor_param;
+  format_tensors_param(tensor_param, sendToNext);
+  format_tensors_param(tensor_param, sendToPrev);
+  RECORD_FUNCTION("oneccl_bindings_for_pytorch::ring_exchange", tensor_param);
+
+  auto work = DispatchStub::ring_exchange(sendToNext, recvFromPrev, sendToPrev, recvFromNext, *this);
+  return work;
+}
+
 c10::intrusive_ptr<C10D_Work> ProcessGroupCCL::recvAnysource(
     std::vector<at::Tensor>& /* unused */,
     int /* unused */)
@@ -32,7 +32,10 @@
 #pragma once
 
 
+#include <atomic>
+#include <condition_variable>
 #include <exception>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -101,6 +104,67 @@ constexpr const char* CCL_SAME_STREAM = "CCL_SAME_STREAM";
 
 constexpr const char* TORCH_LLM_ALLREDUCE = "TORCH_LLM_ALLREDUCE";
 
+// Environment variables which enable the block-quantized allgather on CPU:
+// the number of bits (8 or 4, 0 to disable) and the elements per block.
+constexpr const char* CCL_ALLGATHER_QUANT_BITS = "CCL_ALLGATHER_QUANT_BITS";
+constexpr const char* CCL_ALLGATHER_QUANT_BLOCK = "CCL_ALLGATHER_QUANT_BLOCK";
+
+// Environment variable which enables the lossless compression of the
+// allgathers and broadcasts on CPU.
+constexpr const char* CCL_LOSSLESS_COMPRESSION = "CCL_LOSSLESS_COMPRESSION";
+
+// Environment variables which bound the collectives of a process group that
+// are submitted but not completed yet, in number of ops and in MB of output.
+// 0 (the default) leaves them unbounded.
+constexpr const char* CCL_MAX_INFLIGHT_OPS = "CCL_MAX_INFLIGHT_OPS";
+constexpr const char* CCL_MAX_INFLIGHT_MB = "CCL_MAX_INFLIGHT_MB";
+
+// Admission control of the in-flight collectives of a process group.
+// acquire() blocks the caller while a cap is reached. A single op is always
+// admitted when nothing is in flight, whatever its size.
+class InflightLimiter {
+public:
+  struct Stats {
+    int64_t inflightOps;
+    int64_t inflightBytes;
+    int64_t throttledOps;
+    int64_t throttledNs;
+    int64_t maxThrottledNs;
+  };
+
+  void setLimits(int64_t maxOps, int64_t maxBytes);
+
+  bool enabled() const {
+    return maxOps_.load(std::memory_order_relaxed) > 0 ||
+           maxBytes_.load(std::memory_order_relaxed) > 0;
+  }
+
+  // Throws once the limiter is aborted. Without wait, the op is admitted
+  // even over the limits.
+  void acquire(int64_t bytes, bool wait = true);
+
+  void release(int64_t bytes);
+
+  Stats stats();
+
+  void resetStats();
+
+  // Wake up and fail the callers blocked in acquire().
+  void abort();
+
+private:
+  std::atomic<int64_t> maxOps_{0};
+  std::atomic<int64_t> maxBytes_{0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int64_t ops_ = 0;
+  int64_t bytes_ = 0;
+  int64_t throttledOps_ = 0;
+  int64_t throttledNs_ = 0;
+  int64_t maxThrottledNs_ = 0;
+  bool aborted_ = false;
+};
+
 #if TORCH_VERSION_MAJOR > 1
 using Baseclass = Backend;
 #else
@@ -117,6 +181,8 @@ public:
                  const char* profilingTitle = nullptr,
                  const c10::optional<std::vector<at::Tensor>>& inputTensors = c10::nullopt);
 
+    virtual ~AsyncWorkCCL();
+
     virtual void run() = 0;
 
     c10::intrusive_ptr<c10::ivalue::Future> getFuture() override;
@@ -127,18 +193,99 @@ public:
 
     void finishAsyncWorkCCLError(std::exception_ptr eptr);
 
+#if TORCH_VERSION_MAJOR > 2 || (TORCH_VERSION_MAJOR == 2 && TORCH_VERSION_MINOR >= 1)
+    // Milliseconds between the submission to oneCCL and the completion.
+    float getDuration() const override;
+#endif
+
+    // Steady clock time in nanoseconds.
+    static int64_t nowNs();
+
+    // Record the timestamps of the work, each one only the first time. The
+    // enqueue time is taken when the work is created.
+    void markStarted();
+    void markCompleted();
+
+    // Make result() and the future return results[i] in place of each output
+    // which is outputs[i], e.g. the complex tensors of the caller in place of
+    // the real views the work runs on. Must be called by the thread which
+    // issued the work, before handing it out.
+    void setResultTensors(const std::vector<at::Tensor>& outputs,
+                          const std::vector<at::Tensor>& results);
+
+    // Make the threads synchronizing the work give up with an error. The
+    // CCL requests cannot be cancelled, they are left behind.
+    void abort() override;
+
+    // Non-blocking step of synchronize(): true once the work is completed,
+    // throws if it was aborted or timed out.
+    virtual bool poll() {
+      return isCompleted();
+    }
+
+    bool aborted() const {
+      return aborted_.load() || (groupAborted_ && groupAborted_->load());
+    }
+
+    // Take a slot of the in-flight limiter of the process group, if any,
+    // blocking while it is full. Must be called before run().
+    void acquireInflight();
+
+    // Give the slot back once the work is completed. Idempotent.
+    void releaseInflight();
+
+    using Continuation = std::function<void(AsyncWorkCCL&, std::exception_ptr)>;
+
+    // Run fn on the thread completing the work, with the error of the work if
+    // it failed, before its future is marked completed, or right away if the
+    // work is already completed. Unlike the callbacks of the future, the
+    // continuations are plain C++ and never take the GIL, see work_chain.h.
+    void addContinuation(Continuation fn);
+
+    // True on a thread running the continuations of a work. The ops issued
+    // from there do not block on the in-flight limiter, which would wait for
+    // the progress thread itself.
+    static bool inContinuation();
+
   public:
     std::string debugName;
     // Clone of blockingWait_ from ProcessGroupCCL.
     bool blockingWait_ = true;
     // Clone of useSameStream_ from ProcessGroupCCL.
     bool useSameStream_ = false;
+    // Optional hook run on the thread completing the work, once the CCL event
+    // of the i-th output is done and before the future is marked as completed.
+    // Used by the collectives which post-process the received data.
+    std::function<void(size_t)> completionHook;
+    // Timestamps of the work in nanoseconds, 0 until reached: created by the
+    // backend, first op handed to oneCCL, and seen completed. The queue time
+    // covers the in-flight limiter and the preparation before the transfer.
+    std::atomic<int64_t> enqueueTimeNs_{nowNs()};
+    std::atomic<int64_t> startTimeNs_{0};
+    std::atomic<int64_t> endTimeNs_{0};
+    // In-flight limiter of the process group, set when it has caps.
+    std::shared_ptr<InflightLimiter> inflightLimiter_;
+    // Abort flag of the process group which issued the work.
+    std::shared_ptr<std::atomic<bool>> groupAborted_;
 
   protected:
     friend class ProcessGroupCCL;
     const std::vector<std::vector<at::Tensor>> outputTensors_;
     // The future returned by getFuture.
     c10::intrusive_ptr<at::ivalue::Future> future_;
+    // Set by setResultTensors: what result() and getFuture() return instead.
+    std::vector<std::vector<at::Tensor>> resultTensors_;
+    c10::intrusive_ptr<at::ivalue::Future> resultFuture_;
+    // Bytes accounted to the in-flight limiter while the slot is held.
+    int64_t inflightBytes_ = 0;
+    bool inflightAcquired_ = false;
+    std::atomic<bool> aborted_{false};
+    std::mutex continuationMutex_;
+    std::vector<Continuation> continuations_;
+    bool continued_ = false;
+    std::exception_ptr continuationError_;
+
+    void runContinuations(std::exception_ptr eptr);
   };
 
   explicit ProcessGroupCCL(const c10::intrusive_ptr<Store>& store,
@@ -153,6 +300,44 @@ public:
   }
 #endif
 
+  // Enable (bits = 8 or 4) or disable (bits = 0) the block-quantized
+  // _allgather_base/allgather_into_tensor_coalesced of floating point tensors.
+  void setAllgatherQuantization(int bits, int64_t blockSize);
+
+  // Enable or disable the lossless compression of _allgather_base,
+  // allgather_into_tensor_coalesced and broadcast, for any data type.
+  void setLosslessCompression(bool enabled);
+
+  // Bound the collectives submitted but not completed yet (0 for no bound).
+  void setInflightLimits(int64_t maxOps, int64_t maxBytes);
+
+  // Bootstrap the communicators of this group through a node-local shared
+  // memory segment named after id instead of the store. Must be called on
+  // all the ranks, all on the same node, before the first collective.
+  void setLocalBootstrap(const std::string& id);
+
+  // Share the communicators of this group with the other groups set the
+  // same key, which must have the same ranks in the same order. Must be
+  // called on all the ranks before the first collective.
+  void setCommShareKey(const std::string& key);
+
+  // Number of communicators shared between the groups of this process.
+  static size_t sharedCommsCount();
+
+  // Abort the outstanding work of the group and drop its communicators and
+  // KVS, so that a group for a new membership can be created from a fresh
+  // store without restarting the process. The group is unusable afterwards.
+  // Must not run concurrently with collectives of the same group.
+  void abortGroup();
+
+  bool aborted() const {
+    return groupAborted_->load();
+  }
+
+  // Fails while a chain of ops (see work_chain.h) owns the group, unless
+  // called from a continuation, where the chain issues its steps.
+  void checkNoChainInFlight() const;
+
   void startCoalescing() override;
 
   c10::intrusive_ptr<Work> endCoalescing() override;
@@ -174,6 +359,25 @@ public:
       std::vector<at::Tensor>& tensors,
       const ReduceOptions& opts = ReduceOptions()) override;
 
+  // Out-of-place variants of broadcast, allreduce and reduce: the inputs are
+  // left untouched and the results are written into the outputs, of the same
+  // shapes. Several tensors are communicated as one coalesced op.
+  c10::intrusive_ptr<C10D_Work> broadcastOutOfPlace(
+      std::vector<at::Tensor>& outputTensors,
+      std::vector<at::Tensor>& inputTensors,
+      const BroadcastOptions& opts = BroadcastOptions());
+
+  c10::intrusive_ptr<C10D_Work> allreduceOutOfPlace(
+      std::vector<at::Tensor>& outputTensors,
+      std::vector<at::Tensor>& inputTensors,
+      const AllreduceOptions& opts = AllreduceOptions());
+
+  // Only the outputs of the root rank are written.
+  c10::intrusive_ptr<C10D_Work> reduceOutOfPlace(
+      std::vector<at::Tensor>& outputTensors,
+      std::vector<at::Tensor>& inputTensors,
+      const ReduceOptions& opts = ReduceOptions());
+
   c10::intrusive_ptr<C10D_Work> allgather(
       std::vector<std::vector<at::Tensor>>& outputTensors,
       std::vector<at::Tensor>& inputTensors,
@@ -245,6 +449,23 @@ public:
       std::vector<at::Tensor>& tensor,
       int tag) override;
 
+  // Posts a receive ahead of its use, see RecvStream. The returned work is not
+  // completed by the progress thread: the caller calls synchronize() and
+  // finishAsyncWorkCCL() on it, then wait().
+  c10::intrusive_ptr<AsyncWorkCCL> prepostRecv(
+      std::vector<at::Tensor>& tensors,
+      int srcRank);
+
+  // Sends to the next rank of the ring (rank + 1) and receives from the
+  // previous one, and/or the other way around, as a single op with one work.
+  // Each receive tensor matches the send tensor at the same position. Either
+  // direction may be left empty.
+  c10::intrusive_ptr<C10D_Work> ringExchange(
+      std::vector<at::Tensor>& sendToNext,
+      std::vector<at::Tensor>& recvFromPrev,
+      std::vector<at::Tensor>& sendToPrev,
+      std::vector<at::Tensor>& recvFromNext);
+
   c10::intrusive_ptr<C10D_Work> barrier(
       const BarrierOptions& opts = BarrierOptions()) override;
 
@@ -269,7 +490,10 @@ public:
 
   std::chrono::milliseconds timeout;
 
-  std::unique_ptr<oneccl_bindings_for_pytorch::CCLCommCollector> ccl_member_;
+  // The communicators of the group. abortGroup swaps them for fresh ones
+  // while other threads may be issuing or completing ops, so they are only
+  // read through cclMember(), whose result stays valid after a swap.
+  std::shared_ptr<oneccl_bindings_for_pytorch::CCLCommCollector> cclMember() const;
 
   static std::mutex globalMutex;
 
@@ -283,11 +507,33 @@ public:
 
   bool torch_llm_allreduce_ = false;
 
+  // Bits of the block-quantized allgather, 0 if disabled.
+  int allgatherQuantBits_ = 0;
+
+  // Number of elements sharing a scale in the block-quantized allgather.
+  int64_t allgatherQuantBlockSize_ = 256;
+
+  // Whether the allgathers and broadcasts are losslessly compressed.
+  bool losslessCompression_ = false;
+
+  // Set by abortGroup, shared with the works.
+  std::shared_ptr<std::atomic<bool>> groupAborted_ = std::make_shared<std::atomic<bool>>(false);
+
+  // Set from the creation of a chain of ops until its future completes.
+  std::atomic<bool> chainInFlight_{false};
+
+  // Admission control of the in-flight collectives, shared with the works.
+  std::shared_ptr<InflightLimiter> inflightLimiter_ = std::make_shared<InflightLimiter>();
+
   // Flag to denote if a coalescing groupStart/groupEnd block is active
   bool is_coalescing_ = false;
 
   // Stores device indexes for all collectives run inside a coalescing block
   std::vector<at::Device> coalescedDevices_;
+
+ private:
+  mutable std::mutex cclMemberMutex_;
+  std::shared_ptr<oneccl_bindings_for_pytorch::CCLCommCollector> ccl_member_;
 };
 
 } // namespace c10d
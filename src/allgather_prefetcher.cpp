@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "allgather_prefetcher.h"
+
+#include <algorithm>
+
+namespace oneccl_bindings_for_pytorch {
+
+AllgatherPrefetcher::AllgatherPrefetcher(c10::intrusive_ptr<c10d::ProcessGroupCCL> pg,
+                                         std::vector<at::Tensor> shards,
+                                         int64_t prefetch)
+    : pg_(std::move(pg)), shards_(std::move(shards)) {
+  TORCH_CHECK(prefetch >= 0, "prefetch must not be negative, got ", prefetch);
+  TORCH_CHECK(!shards_.empty(), "AllgatherPrefetcher needs at least one shard");
+
+  int64_t maxNumel = 0;
+  for (auto& shard : shards_) {
+    TORCH_CHECK(shard.scalar_type() == shards_[0].scalar_type() &&
+                shard.device() == shards_[0].device(),
+                "the shards must have the same data type and device");
+    TORCH_CHECK(shard.is_contiguous(), "the shards must be contiguous");
+    maxNumel = std::max(maxNumel, shard.numel());
+  }
+
+  auto numBuffers = std::min<int64_t>(prefetch + 1, shards_.size());
+  for (int64_t i = 0; i < numBuffers; i++) {
+    buffers_.push_back(at::empty({maxNumel * pg_->getSize()}, shards_[0].options()));
+  }
+  works_.resize(numBuffers);
+  owners_.assign(numBuffers, -1);
+
+  reset();
+}
+
+AllgatherPrefetcher::~AllgatherPrefetcher() {
+  try {
+    waitAll();
+  } catch (...) {
+    // The buffers must not be freed under a running gather, errors were
+    // already reported to the consumer waiting on it.
+  }
+}
+
+void AllgatherPrefetcher::issue(int64_t index) {
+  auto slot = index % buffers_.size();
+  auto& shard = shards_[index];
+  auto output = buffers_[slot].narrow(0, 0, shard.numel() * pg_->getSize());
+  works_[slot] = pg_->_allgather_base(output, shard);
+  owners_[slot] = index;
+}
+
+void AllgatherPrefetcher::waitAll() {
+  for (auto& work : works_) {
+    if (work) {
+      work->wait();
+      work.reset();
+    }
+  }
+}
+
+void AllgatherPrefetcher::reset() {
+  waitAll();
+  next_ = 0;
+  for (int64_t i = 0; i < buffers_.size(); i++) {
+    issue(i);
+  }
+}
+
+at::Tensor AllgatherPrefetcher::get(int64_t index) {
+  TORCH_CHECK(index >= 0 && index < shards_.size(), "index ", index, " out of range");
+  auto slot = index % buffers_.size();
+  // The current parameter may be asked again, it is still in its buffer.
+  if (index + 1 == next_ && owners_[slot] == index) {
+    return buffers_[slot].narrow(0, 0, shards_[index].numel() * pg_->getSize());
+  }
+  TORCH_CHECK(index == next_, "the parameters must be gathered in order, expected ", next_,
+              " but got ", index, ", call reset() to start over");
+
+  // The consumer is done with the previous parameter, reuse its buffer.
+  auto ahead = index - 1 + buffers_.size();
+  if (index > 0 && ahead < shards_.size()) {
+    issue(ahead);
+  }
+
+  if (works_[slot]) {
+    works_[slot]->wait();
+    works_[slot].reset();
+  }
+  next_++;
+  return buffers_[slot].narrow(0, 0, shards_[index].numel() * pg_->getSize());
+}
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "ProcessGroupCCL.hpp"
+
+namespace oneccl_bindings_for_pytorch {
+
+// Gathers an ordered list of sharded flat parameters while keeping up to
+// `prefetch` allgathers in flight ahead of the one being consumed. The
+// gathered outputs live in a ring of prefetch + 1 preallocated buffers.
+//
+// get(i) must be called in order. It waits for the gather of i only, and the
+// returned tensor stays valid until the next call to get(), which recycles its
+// buffer for the gather of i + prefetch + 1. reset() re-gathers from the first
+// shard, e.g. for the next forward or backward pass.
+class AllgatherPrefetcher {
+public:
+  AllgatherPrefetcher(c10::intrusive_ptr<c10d::ProcessGroupCCL> pg,
+                      std::vector<at::Tensor> shards,
+                      int64_t prefetch);
+
+  ~AllgatherPrefetcher();
+
+  at::Tensor get(int64_t index);
+
+  void reset();
+
+  int64_t size() const {
+    return shards_.size();
+  }
+
+private:
+  void issue(int64_t index);
+
+  void waitAll();
+
+  c10::intrusive_ptr<c10d::ProcessGroupCCL> pg_;
+  std::vector<at::Tensor> shards_;
+  std::vector<at::Tensor> buffers_;
+  std::vector<c10::intrusive_ptr<c10d::C10D_Work>> works_;
+  // Shard gathered in each buffer, -1 if none.
+  std::vector<int64_t> owners_;
+  int64_t next_ = 0;
+};
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bucket_scheduler.h"
+
+#include <algorithm>
+
+namespace oneccl_bindings_for_pytorch {
+
+GradBucketScheduler::GradBucketScheduler(c10::intrusive_ptr<c10d::ProcessGroupCCL> pg,
+                                         std::vector<at::Tensor> params,
+                                         int64_t bucketCapBytes,
+                                         int64_t firstBucketCapBytes,
+                                         bool average)
+    : pg_(std::move(pg)), average_(average) {
+  TORCH_CHECK(!params.empty(), "GradBucketScheduler needs at least one parameter");
+  TORCH_CHECK(bucketCapBytes > 0 && firstBucketCapBytes > 0, "the bucket caps must be positive");
+
+  int64_t bytes = 0;
+  for (int64_t i = 0; i < params.size(); i++) {
+    auto& param = params[i];
+    TORCH_CHECK(param.device().is_cpu(), "GradBucketScheduler only supports CPU parameters");
+    auto cap = buckets_.size() <= 1 ? firstBucketCapBytes : bucketCapBytes;
+    auto paramBytes = param.numel() * param.element_size();
+    if (buckets_.empty() ||
+        buckets_.back().buffer.scalar_type() != param.scalar_type() ||
+        (bytes + paramBytes > cap && !buckets_.back().params.empty())) {
+      buckets_.emplace_back();
+      buckets_.back().buffer = at::empty({0}, param.options());
+      bytes = 0;
+    }
+    auto& bucket = buckets_.back();
+    bucket.offsets.push_back(bytes / param.element_size());
+    bucket.params.push_back(i);
+    bytes += paramBytes;
+    numels_.push_back(param.numel());
+    bucketOf_.push_back(buckets_.size() - 1);
+  }
+
+  for (auto& bucket : buckets_) {
+    auto numel = bucket.offsets.back() + numels_[bucket.params.back()];
+    bucket.buffer = at::zeros({numel}, bucket.buffer.options());
+    bucket.grads.resize(bucket.params.size());
+  }
+  ready_.assign(params.size(), false);
+  nextIssue_ = buckets_.size() - 1;
+  for (auto& bucket : buckets_) {
+    bucket.pending = bucket.params.size();
+  }
+}
+
+GradBucketScheduler::~GradBucketScheduler() {
+  for (auto& bucket : buckets_) {
+    try {
+      if (bucket.work) {
+        bucket.work->wait();
+      }
+    } catch (...) {
+      // The buckets must not be freed under a running allreduce.
+    }
+  }
+}
+
+void GradBucketScheduler::markReady(int64_t index, const at::Tensor& grad) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TORCH_CHECK(index >= 0 && index < ready_.size(), "index ", index, " out of range");
+  TORCH_CHECK(!ready_[index], "the gradient of parameter ", index, " was marked ready twice, call reset() for the next step");
+  TORCH_CHECK(grad.numel() == numels_[index], "the gradient of parameter ", index, " has ", grad.numel(),
+              " elements, expected ", numels_[index]);
+
+  auto& bucket = buckets_[bucketOf_[index]];
+  auto slot = std::find(bucket.params.begin(), bucket.params.end(), index) - bucket.params.begin();
+  bucket.buffer.narrow(0, bucket.offsets[slot], numels_[index]).view(grad.sizes()).copy_(grad);
+  bucket.grads[slot] = grad;
+  ready_[index] = true;
+  bucket.pending--;
+  issueReady();
+}
+
+void GradBucketScheduler::issueReady() {
+  while (nextIssue_ >= 0 && buckets_[nextIssue_].pending == 0) {
+    issue(nextIssue_);
+    nextIssue_--;
+  }
+}
+
+void GradBucketScheduler::issue(int64_t bucket) {
+  std::vector<at::Tensor> tensors{buckets_[bucket].buffer};
+  buckets_[bucket].work = pg_->allreduce(tensors);
+}
+
+void GradBucketScheduler::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (; nextIssue_ >= 0; nextIssue_--) {
+    auto& bucket = buckets_[nextIssue_];
+    for (int64_t slot = 0; slot < bucket.params.size(); slot++) {
+      if (!ready_[bucket.params[slot]]) {
+        bucket.buffer.narrow(0, bucket.offsets[slot], numels_[bucket.params[slot]]).zero_();
+      }
+    }
+    bucket.pending = 0;
+    issue(nextIssue_);
+  }
+}
+
+std::vector<int64_t> GradBucketScheduler::waitBucket(int64_t index) {
+  TORCH_CHECK(index >= 0 && index < buckets_.size(), "bucket ", index, " out of range");
+  c10::intrusive_ptr<c10d::C10D_Work> work;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& bucket = buckets_[index];
+    if (bucket.done) {
+      return bucket.params;
+    }
+    TORCH_CHECK(bucket.work, "bucket ", index, " is not issued yet, its gradients are not all ready, call flush()");
+    work = bucket.work;
+  }
+  // markReady may run meanwhile for the other buckets.
+  work->wait();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& bucket = buckets_[index];
+  if (!bucket.done) {
+    if (average_) {
+      bucket.buffer.div_(pg_->getSize());
+    }
+    for (int64_t slot = 0; slot < bucket.params.size(); slot++) {
+      auto& grad = bucket.grads[slot];
+      if (grad.defined()) {
+        grad.copy_(bucket.buffer.narrow(0, bucket.offsets[slot], grad.numel()).view(grad.sizes()));
+      }
+    }
+    bucket.work.reset();
+    bucket.done = true;
+  }
+  return bucket.params;
+}
+
+void GradBucketScheduler::waitAll() {
+  flush();
+  // In the order of the next forward pass.
+  for (int64_t i = 0; i < buckets_.size(); i++) {
+    waitBucket(i);
+  }
+}
+
+void GradBucketScheduler::reset() {
+  waitAll();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& bucket : buckets_) {
+    bucket.pending = bucket.params.size();
+    bucket.done = false;
+    std::fill(bucket.grads.begin(), bucket.grads.end(), at::Tensor());
+  }
+  std::fill(ready_.begin(), ready_.end(), false);
+  nextIssue_ = buckets_.size() - 1;
+}
+
+} // namespace oneccl_bindings_for_pytorch
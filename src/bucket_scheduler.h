@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "ProcessGroupCCL.hpp"
+
+namespace oneccl_bindings_for_pytorch {
+
+// Gradient bucketing for data parallel training on CPU. The parameters are
+// given in the order the forward pass uses them and packed in that order into
+// flat buckets of a single data type, of up to bucketCapBytes, except the
+// first one which holds up to firstBucketCapBytes.
+//
+// markReady(i, grad) copies the final gradient of parameter i into its bucket,
+// and a bucket is allreduced as soon as it is full. The buckets are issued in
+// reverse order, the order backward fills them, which is the same on all the
+// ranks. The last bucket reduced is the one the next forward pass uses first,
+// hence its smaller cap to shorten the exposed tail of the communication.
+//
+// waitBucket(b) waits for bucket b and writes the reduced gradients back, so
+// the optimizer can step the parameters of each bucket while the other
+// buckets are still reduced. flush() issues the buckets with parameters which
+// got no gradient this step, their slots reduce zeros. reset() starts the
+// next step.
+class GradBucketScheduler {
+public:
+  GradBucketScheduler(c10::intrusive_ptr<c10d::ProcessGroupCCL> pg,
+                      std::vector<at::Tensor> params,
+                      int64_t bucketCapBytes,
+                      int64_t firstBucketCapBytes,
+                      bool average);
+
+  ~GradBucketScheduler();
+
+  void markReady(int64_t index, const at::Tensor& grad);
+
+  void flush();
+
+  // Returns the indices of the parameters of the bucket.
+  std::vector<int64_t> waitBucket(int64_t bucket);
+
+  void waitAll();
+
+  void reset();
+
+  int64_t bucketOf(int64_t index) const {
+    return bucketOf_.at(index);
+  }
+
+  int64_t numBuckets() const {
+    return buckets_.size();
+  }
+
+private:
+  struct Bucket {
+    std::vector<int64_t> params;
+    std::vector<int64_t> offsets;
+    at::Tensor buffer;
+    std::vector<at::Tensor> grads;
+    int64_t pending = 0;
+    c10::intrusive_ptr<c10d::C10D_Work> work;
+    bool done = false;
+  };
+
+  // Issue the full buckets which are next in the issue order.
+  void issueReady();
+
+  void issue(int64_t bucket);
+
+  c10::intrusive_ptr<c10d::ProcessGroupCCL> pg_;
+  std::vector<int64_t> numels_;
+  std::vector<Bucket> buckets_;
+  std::vector<int64_t> bucketOf_;
+  std::vector<bool> ready_;
+  bool average_;
+  // Next bucket to issue, buckets are issued from the last one.
+  int64_t nextIssue_;
+  std::mutex mutex_;
+};
+
+} // namespace oneccl_bindings_for_pytorch
@@ -1,15 +1,180 @@
 
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include "ccl_comm_collector.h"
 #include "utils.h"
 
 
 namespace oneccl_bindings_for_pytorch {
 
+namespace {
+
+// The shared memory segment rank 0 publishes the main kvs address in.
+struct LocalKVSSegment {
+  std::atomic<int> ready;
+  std::atomic<int> readers;
+  pid_t creator;
+  // Number of the bootstrap with this id in the job, to tell a segment left
+  // by an earlier bootstrap from the one being published.
+  uint64_t generation;
+  uint8_t addr[ccl::kvs::address_max_size];
+};
+
+// Local bootstraps done by the process, by id. All the ranks go through the
+// same bootstraps, so they agree on the generation of each one.
+std::mutex local_generations_mutex;
+std::unordered_map<std::string, uint64_t> local_generations;
+
+uint64_t next_local_generation(const std::string& id) {
+  std::lock_guard<std::mutex> lock(local_generations_mutex);
+  return ++local_generations[id];
+}
+
+std::string local_segment_name(const std::string& id) {
+  std::string name = "/ccl_kvs_" + std::to_string(getuid()) + "_";
+  for (auto c : id) {
+    name += (c == '/') ? '_' : c;
+  }
+  return name;
+}
+
+void publish_local_kvs_addr(const std::string& name, const ccl::kvs::address_type& addr, int size,
+                            uint64_t generation) {
+  // Drop the segment left by a dead process with the same id, if any.
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  TORCH_CHECK(fd >= 0, "Cannot create the shared memory segment ", name, " of the local kvs bootstrap: ", strerror(errno));
+  if (ftruncate(fd, sizeof(LocalKVSSegment)) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    TORCH_CHECK(false, "Cannot size the shared memory segment ", name, ": ", strerror(errno));
+  }
+  void* ptr = mmap(nullptr, sizeof(LocalKVSSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  TORCH_CHECK(ptr != MAP_FAILED, "Cannot map the shared memory segment ", name, ": ", strerror(errno));
+
+  auto segment = static_cast<LocalKVSSegment*>(ptr);
+  segment->creator = getpid();
+  segment->generation = generation;
+  std::copy(addr.begin(), addr.end(), segment->addr);
+  segment->readers.store(0, std::memory_order_relaxed);
+  segment->ready.store(1, std::memory_order_release);
+  munmap(ptr, sizeof(LocalKVSSegment));
+  if (size == 1) {
+    shm_unlink(name.c_str());
+  }
+}
+
+ccl::kvs::address_type read_local_kvs_addr(const std::string& name, int size, uint64_t generation,
+                                           std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    TORCH_CHECK(std::chrono::steady_clock::now() < deadline,
+                "Timed out waiting for rank 0 in the local kvs bootstrap ", name);
+    // Re-open the segment on every retry, rank 0 replaces a stale one under
+    // the same name.
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(LocalKVSSegment)) {
+      if (fd >= 0)
+        close(fd);
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+      continue;
+    }
+    void* ptr = mmap(nullptr, sizeof(LocalKVSSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    TORCH_CHECK(ptr != MAP_FAILED, "Cannot map the shared memory segment ", name, ": ", strerror(errno));
+
+    auto segment = static_cast<LocalKVSSegment*>(ptr);
+    if (segment->ready.load(std::memory_order_acquire) == 0 ||
+        segment->generation != generation ||
+        (kill(segment->creator, 0) != 0 && errno == ESRCH)) {
+      // Not published yet, or left by an earlier bootstrap or a dead process
+      // and about to be replaced.
+      munmap(ptr, sizeof(LocalKVSSegment));
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+      continue;
+    }
+    ccl::kvs::address_type addr;
+    std::copy_n(segment->addr, ccl::kvs::address_max_size, addr.begin());
+    // The last reader removes the segment.
+    if (segment->readers.fetch_add(1) + 1 == size - 1) {
+      shm_unlink(name.c_str());
+    }
+    munmap(ptr, sizeof(LocalKVSSegment));
+    return addr;
+  }
+}
+
+// The communicators shared between the process groups, by share key and
+// devices key. They are kept alive until the process exits so that the
+// groups created later on any rank find them.
+std::mutex shared_comms_mutex;
+std::unordered_map<std::string, std::shared_ptr<Comms>> shared_comms;
+
+std::string shared_comms_key(const std::string& share_key, const std::string& devices_key) {
+  return share_key + "|" + devices_key;
+}
+
+} // namespace
+
+size_t shared_comms_count() {
+  std::lock_guard<std::mutex> lock(shared_comms_mutex);
+  return shared_comms.size();
+}
+
+void CCLCommCollector::set_share_key(const std::string& key) {
+  TORCH_CHECK(ccl_comms.empty(), "The communicators can only be shared before the first collective of the process group");
+  share_key = key;
+}
+
+void CCLCommCollector::unshare() {
+  if (share_key.empty())
+    return;
+  std::lock_guard<std::mutex> lock(shared_comms_mutex);
+  for (auto& comms : ccl_comms) {
+    shared_comms.erase(shared_comms_key(share_key, comms.first));
+  }
+  share_key.clear();
+}
+
+void CCLCommCollector::set_local_bootstrap(const std::string& id, int size, std::chrono::milliseconds timeout) {
+  TORCH_CHECK(!kvs, "The local kvs bootstrap must be set before the first collective of the process group");
+  local_bootstrap_id = id;
+  local_bootstrap_size = size;
+  local_bootstrap_timeout = timeout;
+}
+
 ccl::shared_ptr_class<ccl::kvs> CCLCommCollector::get_kvs(int rank, c10d::Store& store) {
   if (kvs)
     return kvs;
+
+  if (!local_bootstrap_id.empty()) {
+    auto name = local_segment_name(local_bootstrap_id);
+    auto generation = next_local_generation(local_bootstrap_id);
+    if (rank == 0) {
+      call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+          kvs = ccl::create_main_kvs();
+      });
+      publish_local_kvs_addr(name, kvs->get_address(), local_bootstrap_size, generation);
+    } else {
+      auto main_addr = read_local_kvs_addr(name, local_bootstrap_size, generation, local_bootstrap_timeout);
+      call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+          kvs = ccl::create_kvs(main_addr);
+      });
+    }
+    return kvs;
+  }
   // Each process group is with different store, so we use the unique key for
   // broadcast the bootstrap network information.
   std::string storeKey = "ccl_kvs";
@@ -46,6 +211,14 @@ std::shared_ptr<oneccl_bindings_for_pytorch::Comms> CCLCommCollector::get_comms(
     // Reuse the cached communicator if there is one.
     return ccl_comms[devices_key];
   }
+  if (!share_key.empty()) {
+    std::lock_guard<std::mutex> lock(shared_comms_mutex);
+    auto it = shared_comms.find(shared_comms_key(share_key, devices_key));
+    if (it != shared_comms.end()) {
+      ccl_comms.emplace(devices_key, it->second);
+      return it->second;
+    }
+  }
   return {nullptr};
 }
 
@@ -57,6 +230,10 @@ void CCLCommCollector::add_comms(const std::string& devices_key,
   } else {
     ccl_comms.emplace(devices_key, comms);
   }
+  if (!share_key.empty()) {
+    std::lock_guard<std::mutex> lock(shared_comms_mutex);
+    shared_comms[shared_comms_key(share_key, devices_key)] = comms;
+  }
 }
 
 }
\ No newline at end of file
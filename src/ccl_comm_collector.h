@@ -33,6 +33,7 @@
 
 #include <c10/core/Device.h>
 #include <oneapi/ccl.hpp>
+#include <chrono>
 #include <unordered_map>
 #include "ProcessGroupCCL.hpp"
 
@@ -78,18 +79,42 @@ public:
   std::vector<c10::Stream> torch_streams;
 };
 
+// Number of communicators shared between process groups.
+size_t shared_comms_count();
+
 struct CCLCommCollector {
 
   CCLCommCollector() : kvs(nullptr) {};
 
   ccl::shared_ptr_class<ccl::kvs> get_kvs(int rank, c10d::Store& store);
 
+  // Bootstrap the kvs through a shared memory segment named after id instead
+  // of the store. All the ranks of the group must be on the same node and
+  // agree on an id which is unique in the node.
+  void set_local_bootstrap(const std::string& id, int size, std::chrono::milliseconds timeout);
+
+  // Share the communicators with the other process groups of this process
+  // which are set the same key. The groups must have the same ranks, in the
+  // same order, and issue their collectives as a single group would: in the
+  // same order on all the ranks.
+  void set_share_key(const std::string& key);
+  // Stop sharing the communicators of this collector with new groups.
+  void unshare();
+
   std::shared_ptr<oneccl_bindings_for_pytorch::Comms> get_comms(const std::string& devices_key);
   void add_comms(const std::string& devices_key, std::shared_ptr<oneccl_bindings_for_pytorch::Comms> comms);
 
   // ccl kvs to identify the community.
   ccl::shared_ptr_class<ccl::kvs> kvs;
 
+  // Set by set_share_key, empty for communicators private to the group.
+  std::string share_key;
+
+  // Set by set_local_bootstrap, empty to bootstrap through the store.
+  std::string local_bootstrap_id;
+  int local_bootstrap_size = 0;
+  std::chrono::milliseconds local_bootstrap_timeout{0};
+
   // Collects the ccl communicator that the process group has used.
   // The key is a list of devices that an operation is operating on
   // The devices are stored in a device sequence and the cache CCL
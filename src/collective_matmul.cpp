@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "collective_matmul.h"
+
+#include <algorithm>
+
+namespace oneccl_bindings_for_pytorch {
+
+namespace {
+
+void checkOperands(const at::Tensor& x, const at::Tensor& weight, int64_t chunks) {
+  TORCH_CHECK(x.dim() == 2 && weight.dim() == 2, "expected 2-D operands, got ", x.dim(), "-D and ",
+              weight.dim(), "-D");
+  TORCH_CHECK(x.size(1) == weight.size(0), "cannot multiply ", x.sizes(), " by ", weight.sizes());
+  TORCH_CHECK(x.scalar_type() == weight.scalar_type() && x.device() == weight.device(),
+              "the operands must have the same data type and device");
+  TORCH_CHECK(chunks > 0, "chunks must be positive, got ", chunks);
+}
+
+} // namespace
+
+at::Tensor allgather_matmul(const c10::intrusive_ptr<c10d::ProcessGroupCCL>& pg,
+                            const at::Tensor& xShard,
+                            const at::Tensor& weight,
+                            int64_t chunks) {
+  checkOperands(xShard, weight, chunks);
+  const int64_t size = pg->getSize();
+  const int64_t rows = xShard.size(0);
+  const auto shard = xShard.contiguous();
+  auto output = at::empty({size * rows, weight.size(1)}, shard.options());
+  if (rows == 0) {
+    return output;
+  }
+
+  const int64_t chunkRows = (rows + chunks - 1) / chunks;
+  std::vector<at::Tensor> gathered;
+  std::vector<c10::intrusive_ptr<c10d::C10D_Work>> works;
+  for (int64_t offset = 0; offset < rows; offset += chunkRows) {
+    auto input = shard.narrow(0, offset, std::min(chunkRows, rows - offset));
+    gathered.push_back(at::empty({size * input.size(0), input.size(1)}, shard.options()));
+    works.push_back(pg->_allgather_base(gathered.back(), input));
+  }
+
+  // The rows of chunk c of rank r land at r * rows + c * chunkRows.
+  for (size_t c = 0; c < works.size(); c++) {
+    works[c]->wait();
+    const int64_t len = gathered[c].size(0) / size;
+    for (int64_t r = 0; r < size; r++) {
+      auto out = output.narrow(0, r * rows + c * chunkRows, len);
+      at::mm_out(out, gathered[c].narrow(0, r * len, len), weight);
+    }
+  }
+  return output;
+}
+
+at::Tensor matmul_reduce_scatter(const c10::intrusive_ptr<c10d::ProcessGroupCCL>& pg,
+                                 const at::Tensor& x,
+                                 const at::Tensor& weight,
+                                 int64_t chunks) {
+  checkOperands(x, weight, chunks);
+  const int64_t size = pg->getSize();
+  TORCH_CHECK(x.size(0) % size == 0, "the ", x.size(0), " rows of the input cannot be scattered to ",
+              size, " ranks");
+  const int64_t rows = x.size(0) / size;
+  auto output = at::empty({rows, weight.size(1)}, x.options());
+  if (rows == 0) {
+    return output;
+  }
+
+  const int64_t chunkRows = (rows + chunks - 1) / chunks;
+  std::vector<at::Tensor> partials;
+  std::vector<c10::intrusive_ptr<c10d::C10D_Work>> works;
+  for (int64_t offset = 0; offset < rows; offset += chunkRows) {
+    const int64_t len = std::min(chunkRows, rows - offset);
+    // The partial rows destined to each rank, laid out in rank order.
+    partials.push_back(at::empty({size * len, weight.size(1)}, x.options()));
+    for (int64_t r = 0; r < size; r++) {
+      auto out = partials.back().narrow(0, r * len, len);
+      at::mm_out(out, x.narrow(0, r * rows + offset, len), weight);
+    }
+    auto out = output.narrow(0, offset, len);
+    works.push_back(pg->_reduce_scatter_base(out, partials.back()));
+  }
+
+  for (auto& work : works) {
+    work->wait();
+  }
+  return output;
+}
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "ProcessGroupCCL.hpp"
+
+namespace oneccl_bindings_for_pytorch {
+
+// Collective matmuls of tensor and sequence parallel layers, where the
+// communication of a chunk of rows overlaps the GEMM of the previous one.
+// The rows of each rank are split in `chunks` pieces, which are gathered or
+// reduce-scattered by their own collective.
+
+// Returns allgather(xShard) @ weight, of shape [size * m, n], for a shard of
+// shape [m, k] and a weight of shape [k, n]. The GEMM of a chunk runs as soon
+// as it is gathered, while the next chunks are in flight.
+at::Tensor allgather_matmul(const c10::intrusive_ptr<c10d::ProcessGroupCCL>& pg,
+                            const at::Tensor& xShard,
+                            const at::Tensor& weight,
+                            int64_t chunks);
+
+// Returns reduce_scatter(x @ weight), of shape [m, n], for an input of shape
+// [size * m, k] and a weight of shape [k, n]. The partial products are computed
+// chunk by chunk, in the order of the reduce-scatters, and each chunk is
+// reduce-scattered while the next one is computed.
+at::Tensor matmul_reduce_scatter(const c10::intrusive_ptr<c10d::ProcessGroupCCL>& pg,
+                                 const at::Tensor& x,
+                                 const at::Tensor& weight,
+                                 int64_t chunks);
+
+} // namespace oneccl_bindings_for_pytorch
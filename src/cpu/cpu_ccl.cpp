@@ -32,6 +32,7 @@
 #include <condition_variable>
 #include <deque>
 #include <exception>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -39,8 +40,13 @@
 
 #include <ProcessGroupCCL.hpp>
 #include <dispatch_stub.h>
+#include <ATen/Parallel.h>
 #include <ATen/record_function.h>
 #include "../utils.h"
+#include "bitwise_reduce.h"
+#include "lossless.h"
+#include "quantization.h"
+#include "staging_copy.h"
 
 namespace oneccl_bindings_for_pytorch
 {
@@ -73,20 +79,22 @@ Comms& get_ccl_comms(c10d::ProcessGroupCCL& pg, const std::string& devices_key,
 
   TORCH_CHECK(devices.size() == 1, "CPU device size must be 1");
 
-  auto cached_comms = pg.ccl_member_->get_comms(devices_key);
+  // One snapshot, in case the group is aborted meanwhile.
+  auto member = pg.cclMember();
+  auto cached_comms = member->get_comms(devices_key);
   if (cached_comms) {
     return *cached_comms;
   }
 
   ccl::vector_class<ccl::communicator> cpu_comms;
-  auto kvs = pg.ccl_member_->get_kvs(pg.getRank(), *pg.store_);
+  auto kvs = member->get_kvs(pg.getRank(), *pg.store_);
   cpu_comms.emplace_back(
     call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&](){
       CCL_CHECK(return ccl::create_communicator(pg.getSize(), pg.getRank(), kvs););
       })
   );
   std::shared_ptr<Comms> cpu_comms_ptr = std::make_shared<Comms>(cpu_comms);
-  pg.ccl_member_->add_comms(devices_key, cpu_comms_ptr);
+  member->add_comms(devices_key, cpu_comms_ptr);
 
   return *cpu_comms_ptr.get();
 }
@@ -109,15 +117,227 @@ public:
 
 };
 
+// Allgather of a flat input into a flat output holding world_size inputs.
+// When the output has another floating point type than the input, the input
+// is cast straight into the slot of this rank in the output, which is then
+// gathered in place. The converted shard is never materialized separately.
+ccl::event allgather_into_tensor(const at::Tensor& input,
+                                 const at::Tensor& output,
+                                 int rank,
+                                 int world_size,
+                                 ccl::allgatherv_attr& attr,
+                                 ccl::communicator& comm) {
+  const int64_t count = input.numel();
+  std::vector<size_t> recvCounts(world_size, count);
+  void* sendBuf = input.data_ptr();
+  if (input.scalar_type() != output.scalar_type()) {
+    auto slot = output.view({-1}).narrow(0, rank * count, count);
+    slot.copy_(input.view({-1}));
+    sendBuf = slot.data_ptr();
+  }
+
+  ccl::event ret_evt;
+  call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+    CCL_CHECK(ret_evt = ccl::allgatherv(sendBuf,
+                                        (size_t) count,
+                                        output.data_ptr(),
+                                        recvCounts,
+                                        cclDatatypes.at(output.scalar_type()),
+                                        comm,
+                                        attr));
+  });
+  return ret_evt;
+}
+
+// Bytes of quantized data per rank exchanged by each step of the quantized allgather pipeline.
+constexpr int64_t kQuantChunkBytes = 1 << 20;
+
+// Bitwise reductions are done by the bindings, except the logical AND/OR of
+// bool tensors which oneCCL does as MIN/MAX.
+bool use_bitwise_allreduce(const c10d::ReduceOp& op, const std::vector<at::Tensor>& tensors) {
+  if (!is_bitwise_op(op))
+    return false;
+  bool allBool = true;
+  for (const auto& tensor : tensors) {
+    TORCH_CHECK(at::isIntegralType(tensor.scalar_type(), /*includeBool=*/true),
+                "bitwise reductions only support integer and bool tensors, got ", tensor.scalar_type());
+    allBool = allBool && tensor.scalar_type() == at::kBool;
+  }
+  return !allBool || op == c10d::ReduceOp::BXOR;
+}
+
+BitwiseOp to_bitwise_op(const c10d::ReduceOp& op) {
+  if (op == c10d::ReduceOp::BAND)
+    return BitwiseOp::AND;
+  if (op == c10d::ReduceOp::BOR)
+    return BitwiseOp::OR;
+  return BitwiseOp::XOR;
+}
+
+bool use_fp8_allreduce(const std::vector<at::Tensor>& tensors) {
+#if TORCH_VERSION_MAJOR > 2 || (TORCH_VERSION_MAJOR == 2 && TORCH_VERSION_MINOR >= 1)
+  return at::isFloat8Type(tensors[0].scalar_type());
+#else
+  return false;
+#endif
+}
+
+// Reduce the world_size fp8 slices of recvBuf into output, accumulating in fp32.
+void fp8_reduce(const at::Tensor& recvBuf, int world_size, const at::Tensor& output,
+                at::ScalarType type, const c10d::ReduceOp& op) {
+  auto slices = recvBuf.view(type).view({world_size, -1}).to(at::kFloat);
+  at::Tensor acc;
+  if (op == c10d::ReduceOp::SUM || op == c10d::ReduceOp::AVG) {
+    acc = slices.sum(0);
+    if (op == c10d::ReduceOp::AVG)
+      acc.div_(world_size);
+  } else if (op == c10d::ReduceOp::MIN) {
+    acc = slices.amin(0);
+  } else if (op == c10d::ReduceOp::MAX) {
+    acc = slices.amax(0);
+  } else if (op == c10d::ReduceOp::PRODUCT) {
+    acc = slices.prod(0);
+  } else {
+    TORCH_CHECK(false, "the reduce op is not supported for fp8 tensors");
+  }
+  output.view(type).copy_(acc);
+}
+
+// Bytes of the tensors reduced by each step of the local allreduce pipeline.
+constexpr int64_t kLocalReduceChunkBytes = 1 << 20;
+
+// Index of the current call of a run function. collective() calls it once per
+// input, in order, on the issuing thread, and the copies of the lambda share
+// the counter. Used to look up the state of each chunk of a pipelined op.
+class RunIndex {
+public:
+  size_t operator()() const {
+    return (*next_)++;
+  }
+
+private:
+  std::shared_ptr<size_t> next_ = std::make_shared<size_t>(0);
+};
+
+bool use_quantized_allgather(const ProcessGroupCCL& pg,
+                             const std::vector<at::Tensor>& inputs,
+                             const std::vector<at::Tensor>& outputs) {
+  if (pg.allgatherQuantBits_ == 0)
+    return false;
+  for (const auto i : c10::irange(inputs.size())) {
+    // fp8 shards are not worth quantizing.
+    if (inputs[i].numel() == 0 || inputs[i].element_size() < 2 ||
+        !at::isFloatingType(inputs[i].scalar_type()) ||
+        !at::isFloatingType(outputs[i].scalar_type()))
+      return false;
+  }
+  return true;
+}
+
+// Raw bytes per rank of each step of the lossless compressed collectives.
+constexpr int64_t kLosslessChunkBytes = 1 << 20;
+// Chunks whose compressed sizes are exchanged together. The next batch is
+// compressed and its sizes exchanged while the current one is transferred.
+constexpr size_t kLosslessBatchChunks = 4;
+// Below this many raw bytes per rank the exchange of the compressed sizes
+// costs more than the compression saves, so the plain collective is used.
+constexpr int64_t kLosslessMinBytes = 256 << 10;
+
+// Only allgather and broadcast are compressed: all_to_all and the
+// point-to-point operations stay uncompressed.
+bool use_lossless_compression(const ProcessGroupCCL& pg,
+                              const std::vector<at::Tensor>& inputs,
+                              const std::vector<at::Tensor>& outputs) {
+  if (!pg.losslessCompression_)
+    return false;
+  int64_t bytes = 0;
+  for (const auto i : c10::irange(inputs.size())) {
+    if (inputs[i].numel() == 0 || outputs[i].scalar_type() != inputs[i].scalar_type() ||
+        !outputs[i].is_contiguous())
+      return false;
+    bytes += inputs[i].numel() * inputs[i].element_size();
+  }
+  return bytes >= kLosslessMinBytes;
+}
+
+// A chunk of a shard of the lossless compressed collectives.
+struct LosslessChunk {
+  // Contiguous source and destination of the chunk, and its byte range.
+  at::Tensor input;
+  at::Tensor output;
+  int64_t shardBytes;
+  int64_t offset;
+  int64_t bytes;
+  int64_t elementSize;
+  bool delta;
+  at::Tensor sendBuf;
+  int64_t sendBytes = 0;
+  // Compressed bytes of each rank, and where they land in recvBuf.
+  std::vector<size_t> recvCounts;
+  std::vector<int64_t> recvOffsets;
+  at::Tensor recvBuf;
+};
+
+// The compressed sizes of a batch of chunks, and the event of their exchange.
+struct LosslessBatch {
+  at::Tensor sizes;
+  ccl::event event;
+};
+
+// The chunks [begin, end) of batch b.
+std::pair<size_t, size_t> lossless_batch_range(const std::vector<LosslessChunk>& chunks, size_t b) {
+  const size_t begin = b * kLosslessBatchChunks;
+  return {begin, std::min(chunks.size(), begin + kLosslessBatchChunks)};
+}
+
+// Split the shards in chunks of whole elements.
+std::shared_ptr<std::vector<LosslessChunk>> lossless_chunks(const std::vector<at::Tensor>& inputs,
+                                                            const std::vector<at::Tensor>& outputs) {
+  auto chunks = std::make_shared<std::vector<LosslessChunk>>();
+  for (const auto i : c10::irange(inputs.size())) {
+    auto input = inputs[i].contiguous();
+    const int64_t elementSize = input.element_size();
+    const int64_t shardBytes = input.numel() * elementSize;
+    const int64_t chunkBytes = std::max<int64_t>(1, kLosslessChunkBytes / elementSize) * elementSize;
+    for (int64_t offset = 0; offset < shardBytes; offset += chunkBytes) {
+      LosslessChunk chunk;
+      chunk.input = input;
+      chunk.output = outputs[i];
+      chunk.shardBytes = shardBytes;
+      chunk.offset = offset;
+      chunk.bytes = std::min(chunkBytes, shardBytes - offset);
+      chunk.elementSize = elementSize;
+      chunk.delta = lossless_use_delta(input.scalar_type());
+      chunks->push_back(std::move(chunk));
+    }
+  }
+  return chunks;
+}
+
+void lossless_encode_chunks(std::vector<LosslessChunk>& chunks, size_t first, size_t last) {
+  at::parallel_for(first, last, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      auto& chunk = chunks[c];
+      chunk.sendBuf = at::empty({lossless_bound(chunk.bytes)}, chunk.input.options().dtype(at::kByte));
+      chunk.sendBytes = lossless_encode(static_cast<const uint8_t*>(chunk.input.data_ptr()) + chunk.offset,
+                                        chunk.bytes,
+                                        chunk.elementSize,
+                                        chunk.delta,
+                                        chunk.sendBuf.data_ptr<uint8_t>());
+    }
+  });
+}
+
 } //namespace anonymous
 
 
 class VanillaCPU final: public DispatchStub {
 public:
 
+  // The worker thread is started by the first collective, not when the
+  // library is loaded.
   VanillaCPU() {
     stop_=false;
-    workerThread_ = std::thread(&VanillaCPU::runLoop, this);
   }
 
   ~VanillaCPU() {destroy();}
@@ -138,6 +358,21 @@ protected:
                                                          const ReduceOptions& opts,
                                                          ProcessGroupCCL& pg) override;
 
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> allreduce_oop_(std::vector<at::Tensor>& outputTensors,
+                                                                std::vector<at::Tensor>& inputTensors,
+                                                                const AllreduceOptions& opts,
+                                                                ProcessGroupCCL& pg) override;
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> reduce_oop_(std::vector<at::Tensor>& outputTensors,
+                                                             std::vector<at::Tensor>& inputTensors,
+                                                             const ReduceOptions& opts,
+                                                             ProcessGroupCCL& pg) override;
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> broadcast_oop_(std::vector<at::Tensor>& outputTensors,
+                                                                std::vector<at::Tensor>& inputTensors,
+                                                                const BroadcastOptions& opts,
+                                                                ProcessGroupCCL& pg) override;
+
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> reduce_scatter_(std::vector<at::Tensor>& outputTensors,
                                                                     std::vector<std::vector<at::Tensor>>& inputTensors,
                                                                     const ReduceScatterOptions& opts,
@@ -162,6 +397,11 @@ protected:
                                                                      const AllgatherOptions& opts,
                                                                      ProcessGroupCCL& pg_ccl) override;
 
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> allgather_into_tensor_coalesced_(std::vector<at::Tensor>& outputTensors,
+                                                                                     std::vector<at::Tensor>& inputTensors,
+                                                                                     const AllgatherOptions& opts,
+                                                                                     ProcessGroupCCL& pg_ccl) override;
+
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> gather_(std::vector<std::vector<at::Tensor>>& outputTensors,
                                                             std::vector<at::Tensor>& inputTensors,
                                                             const GatherOptions& opts,
@@ -184,26 +424,81 @@ protected:
                                                              const AllToAllOptions& opts,
                                                              ProcessGroupCCL& pg) override;
 
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> send_(std::vector<at::Tensor>& tensors,
+                                                        int dstRank,
+                                                        int tag,
+                                                        ProcessGroupCCL& pg) override;
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> recv_(std::vector<at::Tensor>& tensors,
+                                                        int srcRank,
+                                                        int tag,
+                                                        ProcessGroupCCL& pg) override;
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> prepost_recv_(std::vector<at::Tensor>& tensors,
+                                                                int srcRank,
+                                                                ProcessGroupCCL& pg) override;
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> ring_exchange_(std::vector<at::Tensor>& sendToNext,
+                                                                 std::vector<at::Tensor>& recvFromPrev,
+                                                                 std::vector<at::Tensor>& sendToPrev,
+                                                                 std::vector<at::Tensor>& recvFromNext,
+                                                                 ProcessGroupCCL& pg) override;
+
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> barrier_(const BarrierOptions& opts,
                                                                 ProcessGroupCCL& pg) override;
   void destroy();
   void reset() override {}
   void runLoop();
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> enqueue(c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> & work);
+  // Point-to-point works are polled by the progress thread instead of being
+  // waited for in order: a receive whose sender is late would otherwise hold
+  // up the completion of every work queued after it.
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> enqueueP2P(c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> & work);
 private:
   bool stop_;
   std::mutex pgMutex_;
+  std::once_flag workerStarted_;
   std::thread workerThread_;
 
   std::deque<c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>> queue_;
+  std::deque<c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>> p2pQueue_;
   std::condition_variable queueProduceCV_;
   std::condition_variable queueConsumeCV_;
 
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> _p2p(std::vector<at::Tensor>& tensors,
+                                                       int peer,
+                                                       bool isSend,
+                                                       ProcessGroupCCL& pg);
+
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> _reduce_oop(at::Tensor& outputTensor,
                                                          at::Tensor& inputTensor,
                                                          const ReduceOptions& opts,
                                                          ProcessGroupCCL& pg_ccl);
 
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> _allreduce_local(std::vector<at::Tensor>& tensors,
+                                                                     const c10d::ReduceOp& op,
+                                                                     c10d::OpType opType,
+                                                                     ProcessGroupCCL& pg_ccl);
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> _allgather_quantized(std::vector<at::Tensor>& outputTensors,
+                                                                         std::vector<at::Tensor>& inputTensors,
+                                                                         c10d::OpType opType,
+                                                                         ProcessGroupCCL& pg_ccl);
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> _allgather_lossless(std::vector<at::Tensor>& outputTensors,
+                                                                        std::vector<at::Tensor>& inputTensors,
+                                                                        c10d::OpType opType,
+                                                                        ProcessGroupCCL& pg_ccl);
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> _broadcast_lossless(std::vector<at::Tensor>& tensors,
+                                                                        const BroadcastOptions& opts,
+                                                                        ProcessGroupCCL& pg);
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> _reduce_scatter_base_upcast(at::Tensor& outputTensor,
+                                                                                at::Tensor& inputTensor,
+                                                                                const ReduceScatterOptions& opts,
+                                                                                ProcessGroupCCL& pg_ccl);
+
 };
 
 struct RegisterCPUPMethods {
@@ -248,7 +543,16 @@ std::shared_ptr<cpu_completion_callback<RunF>> make_cpu_callback(RunF f) {
 }
 
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::enqueue(c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> & work) {
-  work->run();
+  // Blocks while the process group has too many collectives in flight.
+  work->acquireInflight();
+  {
+    ScopedPhase phase(Phase::SUBMIT);
+    work->run();
+  }
+  ScopedPhase phase(Phase::QUEUE);
+  std::call_once(workerStarted_, [this]() {
+    workerThread_ = std::thread(&VanillaCPU::runLoop, this);
+  });
   std::unique_lock<std::mutex> lock(pgMutex_);
   queue_.push_back(work);
   lock.unlock();
@@ -256,6 +560,40 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::enqueue(c10::intru
   return work;
 }
 
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::enqueueP2P(c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> & work) {
+  {
+    ScopedPhase phase(Phase::SUBMIT);
+    work->run();
+  }
+  ScopedPhase phase(Phase::QUEUE);
+  std::call_once(workerStarted_, [this]() {
+    workerThread_ = std::thread(&VanillaCPU::runLoop, this);
+  });
+  std::unique_lock<std::mutex> lock(pgMutex_);
+  p2pQueue_.push_back(work);
+  lock.unlock();
+  queueProduceCV_.notify_one();
+  return work;
+}
+
+// Completes the point-to-point works which are done, keeps the others.
+static void pollP2P(std::deque<c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>>& works) {
+  for (auto it = works.begin(); it != works.end();) {
+    auto& work = *it;
+    try {
+      if (!work->poll()) {
+        ++it;
+        continue;
+      }
+      ScopedPhase phase(Phase::FUTURE);
+      work->finishAsyncWorkCCL();
+    } catch (...) {
+      work->finishAsyncWorkCCLError(std::current_exception());
+    }
+    it = works.erase(it);
+  }
+}
+
 void VanillaCPU::destroy() {
   std::unique_lock<std::mutex> lock(pgMutex_);
   queueConsumeCV_.wait(lock, [&] { return queue_.empty(); });
@@ -267,32 +605,59 @@ void VanillaCPU::destroy() {
   lock.unlock();
   queueProduceCV_.notify_all();
 
-  // Join the single worker thread
-  workerThread_.join();
+  // Join the single worker thread, if any collective started it
+  if (workerThread_.joinable())
+    workerThread_.join();
 }
 
 void VanillaCPU::runLoop() {
+  std::deque<c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>> batch;
+  std::deque<c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>> p2p;
   std::unique_lock<std::mutex> lock(pgMutex_);
-  while (!stop_) {
+  // Drain the queue before stopping, the continuations of the last works may
+  // have issued more.
+  while (!stop_ || !queue_.empty() || !p2pQueue_.empty() || !p2p.empty()) {
+    p2p.insert(p2p.end(), p2pQueue_.begin(), p2pQueue_.end());
+    p2pQueue_.clear();
     if (queue_.empty()) {
-      queueProduceCV_.wait(lock);
+      if (p2p.empty()) {
+        queueProduceCV_.wait(lock);
+        continue;
+      }
+      lock.unlock();
+      pollP2P(p2p);
+      lock.lock();
+      if (queue_.empty() && p2pQueue_.empty() && !p2p.empty()) {
+        queueProduceCV_.wait_for(lock, std::chrono::microseconds(kSynchronizeBusyWaitMicro));
+      }
       continue;
     }
 
-    auto work = std::move(queue_.front());
-
-    queue_.pop_front();
+    // Take every queued work at once: when several ops finish together they
+    // are completed back to back, without a round trip through the lock and
+    // the producers for each of them.
+    batch.swap(queue_);
 
     lock.unlock();
     queueConsumeCV_.notify_one();
 
-    try {
-      work->synchronize();
-      work->finishAsyncWorkCCL();
+    for (auto& work : batch) {
+      try {
+        {
+          ScopedPhase phase(Phase::COMPLETION);
+          work->synchronize();
+        }
+        work->releaseInflight();
+        ScopedPhase phase(Phase::FUTURE);
+        work->finishAsyncWorkCCL();
 
-    } catch (...) {
-      work->finishAsyncWorkCCLError(std::current_exception());
+      } catch (...) {
+        work->releaseInflight();
+        work->finishAsyncWorkCCLError(std::current_exception());
+      }
     }
+    batch.clear();
+    pollP2P(p2p);
 
     lock.lock();
   }
@@ -303,6 +668,10 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::allreduce_(std::ve
                                                                       ProcessGroupCCL& pg) {
   checkSingleTensor(tensors);
 
+  if (use_bitwise_allreduce(opts.reduceOp, tensors) || use_fp8_allreduce(tensors)) {
+    return _allreduce_local(tensors, opts.reduceOp, c10d::OpType::ALLREDUCE, pg);
+  }
+
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
   work = collective<get_ccl_comms, CPUWorkCCL>(
           pg,
@@ -318,7 +687,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::allreduce_(std::ve
                                                      output.data_ptr(),
                                                      (size_t) input.numel(),
                                                      cclDatatypes.at(input.scalar_type()),
-                                                     cclOps.at(opts.reduceOp),
+                                                     get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                                      comm,
                                                      attr););
               });
@@ -334,6 +703,10 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::allreduce_(std::ve
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::allreduce_coalesced_(std::vector<at::Tensor>& tensors,
                                                                 const AllreduceOptions& opts,
                                                                 ProcessGroupCCL& pg) {
+  if (use_bitwise_allreduce(opts.reduceOp, tensors) || use_fp8_allreduce(tensors)) {
+    return _allreduce_local(tensors, opts.reduceOp, c10d::OpType::COALESCED, pg);
+  }
+
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
   work = collective<get_ccl_comms, CPUWorkCCL>(
           pg,
@@ -349,7 +722,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::allreduce_coalesce
                                                      output.data_ptr(),
                                                      (size_t) input.numel(),
                                                      cclDatatypes.at(input.scalar_type()),
-                                                     cclOps.at(opts.reduceOp),
+                                                     get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                                      comm,
                                                      attr););
               });
@@ -363,6 +736,128 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::allreduce_coalesce
 }
 
 
+// _allreduce_local runs the allreduces that oneCCL cannot reduce: bitwise ops
+// and fp8 data. They are done as a reduce-scatter followed by an allgather, so
+// each rank sends and receives about twice the data, as a ring allreduce would:
+// - an alltoall hands the i-th segment of every rank to rank i;
+// - rank i reduces its segments locally, by the bitwise kernels or in fp32 for
+//   fp8, straight into its segment of the tensor;
+// - the reduced segments are allgathered in place.
+// The tensors are split in chunks. The two phases must be issued in the same
+// order on all ranks, so the reduction runs on the issuing thread, while the
+// alltoall of the next chunk is already in flight. Issuing the allgathers from
+// the progress thread instead would race with the ops the caller issues
+// meanwhile, so the op is blocking even when async, as the README documents.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_allreduce_local(std::vector<at::Tensor>& tensors,
+                                                                               const c10d::ReduceOp& op,
+                                                                               c10d::OpType opType,
+                                                                               ProcessGroupCCL& pg_ccl) {
+  const int world_size = pg_ccl.getSize();
+  const int rank = pg_ccl.getRank();
+  std::function<void(const at::Tensor&, const at::Tensor&)> reduceSegments;
+  if (is_bitwise_op(op)) {
+    reduceSegments = [world_size, bitwiseOp = to_bitwise_op(op)](const at::Tensor& recvBuf, const at::Tensor& output) {
+      bitwise_reduce(recvBuf, world_size, output, bitwiseOp);
+    };
+  } else {
+    reduceSegments = [world_size, type = tensors[0].scalar_type(), op](const at::Tensor& recvBuf, const at::Tensor& output) {
+      fp8_reduce(recvBuf, world_size, output, type, op);
+    };
+  }
+
+  struct LocalReduceChunk {
+    at::Tensor data;
+    // Bytes of the segment of each rank, the last ones may be shorter or empty.
+    std::vector<size_t> segmentCounts;
+    // Segments of this rank received from all the ranks, only alive between
+    // the two phases.
+    at::Tensor recvBuf;
+    ccl::event scatterEvent;
+  };
+  auto chunks = std::make_shared<std::vector<LocalReduceChunk>>();
+  std::vector<at::Tensor> chunkInputs;
+  for (const auto& tensor : tensors) {
+    TORCH_CHECK(tensor.is_contiguous(), "bitwise and fp8 reductions need contiguous tensors");
+    auto bytes = tensor.view({-1}).view(at::kByte);
+    // An empty tensor still gets one (empty) chunk.
+    for (int64_t offset = 0; offset == 0 || offset < bytes.numel(); offset += kLocalReduceChunkBytes) {
+      auto chunk = bytes.narrow(0, offset, std::min(kLocalReduceChunkBytes, bytes.numel() - offset));
+      const int64_t segment = (chunk.numel() + world_size - 1) / world_size;
+      std::vector<size_t> counts(world_size);
+      for (const auto r : c10::irange(world_size)) {
+        counts[r] = std::max<int64_t>(0, std::min(segment, chunk.numel() - r * segment));
+      }
+      chunks->push_back({chunk, std::move(counts), at::Tensor(), ccl::event()});
+      chunkInputs.push_back(chunk);
+    }
+  }
+
+  // Reduce-scatter phase of a chunk: every rank receives its own segment from all the ranks.
+  auto scatterChunk = [chunks, world_size, rank](size_t i, ccl::communicator& comm) {
+    auto& chunk = (*chunks)[i];
+    const size_t count = chunk.segmentCounts[rank];
+    chunk.recvBuf = at::empty({(int64_t)(world_size * count)}, chunk.data.options());
+    std::vector<size_t> recvCounts(world_size, count);
+    call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+      CCL_CHECK(chunk.scatterEvent = ccl::alltoallv(chunk.data.data_ptr(),
+                                                    chunk.segmentCounts,
+                                                    chunk.recvBuf.data_ptr(),
+                                                    recvCounts,
+                                                    ccl::datatype::uint8,
+                                                    comm));
+    });
+  };
+
+  RunIndex nextChunk;
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg_ccl,
+          chunkInputs,
+          chunkInputs,
+          [=](at::Tensor input,
+              at::Tensor /*output*/,
+              ccl::allgatherv_attr attr,
+              ccl::communicator& comm) {
+            RECORD_FUNCTION("oneccl_bindings_for_pytorch::cpu::allreduce_local", std::vector<c10::IValue>({input}));
+            const size_t i = nextChunk();
+            if (i == 0) {
+              scatterChunk(0, comm);
+            }
+            if (i + 1 < chunks->size()) {
+              scatterChunk(i + 1, comm);
+            }
+
+            auto& chunk = (*chunks)[i];
+            // The whole chunk must be sent before the allgather overwrites it.
+            chunk.scatterEvent.wait();
+            int64_t offset = 0;
+            for (const auto r : c10::irange(rank)) {
+              offset += chunk.segmentCounts[r];
+            }
+            auto segment = chunk.data.narrow(0, offset, chunk.segmentCounts[rank]);
+            reduceSegments(chunk.recvBuf, segment);
+            chunk.recvBuf = at::Tensor();
+
+            ccl::event ret_evt;
+            call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+              CCL_CHECK(ret_evt = ccl::allgatherv(segment.data_ptr(),
+                                                  (size_t) segment.numel(),
+                                                  chunk.data.data_ptr(),
+                                                  chunk.segmentCounts,
+                                                  ccl::datatype::uint8,
+                                                  comm,
+                                                  attr));
+            });
+            return ret_evt;
+          },
+          opType,
+          "oneccl_bindings_for_pytorch::cpu_work::allreduce_local");
+
+  work->debugName = std::string("cpu::allreduce_local");
+  enqueue(work);
+  return work;
+}
+
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::reduce_(std::vector<at::Tensor>& tensors,
                                                                    const ReduceOptions& opts,
                                                                    ProcessGroupCCL& pg) {
@@ -383,7 +878,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::reduce_(std::vecto
                                                   output.data_ptr(),
                                                   (size_t)input.numel(),
                                                   cclDatatypes.at(input.scalar_type()),
-                                                  cclOps.at(opts.reduceOp),
+                                                  get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                                   (int)opts.rootRank,
                                                   comm,
                                                   attr););
@@ -422,7 +917,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_reduce_oop(at::Te
                                 output.data_ptr(),
                                 (size_t) input.numel(),
                                 cclDatatypes.at(input.scalar_type()),
-                                cclOps.at(opts.reduceOp),
+                                get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                 root,
                                 comm));
       });
@@ -442,6 +937,10 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::broadcast_(std::ve
                                                                       ProcessGroupCCL& pg) {
   checkSingleTensor(tensors);
 
+  if (use_lossless_compression(pg, tensors, tensors)) {
+    return _broadcast_lossless(tensors, opts, pg);
+  }
+
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
   work = collective<get_ccl_comms, CPUWorkCCL>(
           pg,
@@ -470,6 +969,121 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::broadcast_(std::ve
 }
 
 
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::allreduce_oop_(std::vector<at::Tensor>& outputTensors,
+                                                                          std::vector<at::Tensor>& inputTensors,
+                                                                          const AllreduceOptions& opts,
+                                                                          ProcessGroupCCL& pg) {
+  // The local allreduces reduce in place, into the tensors they scatter from.
+  if (use_bitwise_allreduce(opts.reduceOp, inputTensors) || use_fp8_allreduce(inputTensors)) {
+    return DispatchStub::allreduce_oop_(outputTensors, inputTensors, opts, pg);
+  }
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg,
+          inputTensors,
+          outputTensors,
+          [=](at::Tensor input,
+              at::Tensor output,
+              ccl::allreduce_attr attr,
+              ccl::communicator& comm){
+              ccl::event ret_evt;
+              call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&](){
+                  CCL_CHECK(ret_evt = ccl::allreduce(input.data_ptr(),
+                                                     output.data_ptr(),
+                                                     (size_t) input.numel(),
+                                                     cclDatatypes.at(input.scalar_type()),
+                                                     get_ccl_reduction(opts.reduceOp, input.scalar_type()),
+                                                     comm,
+                                                     attr););
+              });
+              return ret_evt;
+          },
+          inputTensors.size() == 1 ? c10d::OpType::ALLREDUCE : c10d::OpType::COALESCED,
+          "oneccl_bindings_for_pytorch::cpu_work::allreduce_oop");
+  work->debugName = std::string("cpu::allreduce_oop");
+  enqueue(work);
+  return work;
+}
+
+// The output of a rank other than the root is left untouched.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::reduce_oop_(std::vector<at::Tensor>& outputTensors,
+                                                                       std::vector<at::Tensor>& inputTensors,
+                                                                       const ReduceOptions& opts,
+                                                                       ProcessGroupCCL& pg) {
+  if (inputTensors.size() == 1) {
+    return _reduce_oop(outputTensors[0], inputTensors[0], opts, pg);
+  }
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg,
+          inputTensors,
+          outputTensors,
+          [=](at::Tensor input,
+              at::Tensor output,
+              ccl::reduce_attr attr,
+              ccl::communicator& comm) {
+              ccl::event ret_evt;
+              call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&](){
+                  CCL_CHECK(ret_evt = ccl::reduce(input.data_ptr(),
+                                                  output.data_ptr(),
+                                                  (size_t)input.numel(),
+                                                  cclDatatypes.at(input.scalar_type()),
+                                                  get_ccl_reduction(opts.reduceOp, input.scalar_type()),
+                                                  (int)opts.rootRank,
+                                                  comm,
+                                                  attr););
+              });
+              return ret_evt;
+          },
+          c10d::OpType::COALESCED,
+          "oneccl_bindings_for_pytorch::cpu_work::reduce_oop");
+
+  work->debugName = std::string("cpu::reduce_oop");
+  enqueue(work);
+  return work;
+}
+
+// oneCCL broadcasts in place, so the root sends straight from its input and
+// the other ranks receive into their output. The root copies its input into
+// its output while the broadcast is in flight.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::broadcast_oop_(std::vector<at::Tensor>& outputTensors,
+                                                                          std::vector<at::Tensor>& inputTensors,
+                                                                          const BroadcastOptions& opts,
+                                                                          ProcessGroupCCL& pg) {
+  const bool isRoot = pg.getRank() == opts.rootRank;
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg,
+          inputTensors,
+          outputTensors,
+          [=](at::Tensor input,
+              at::Tensor output,
+              ccl::broadcast_attr attr,
+              ccl::communicator& comm) {
+              at::Tensor& buffer = isRoot ? input : output;
+              ccl::event ret_evt;
+              call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&](){
+                  CCL_CHECK(ret_evt = ccl::broadcast(buffer.data_ptr(),
+                                                     (size_t) buffer.numel(),
+                                                     cclDatatypes.at(buffer.scalar_type()),
+                                                     (size_t) opts.rootRank,
+                                                     comm));
+              });
+              if (isRoot && output.data_ptr() != input.data_ptr()) {
+                output.copy_(input);
+              }
+              return ret_evt;
+          },
+          inputTensors.size() == 1 ? c10d::OpType::BROADCAST : c10d::OpType::COALESCED,
+          "oneccl_bindings_for_pytorch::cpu_work::broadcast_oop");
+
+  work->debugName = std::string("cpu::broadcast_oop");
+  enqueue(work);
+  return work;
+}
+
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::allgather_(std::vector<std::vector<at::Tensor>>& outputTensors,
                                                                       std::vector<at::Tensor>& inputTensors,
                                                                       const AllgatherOptions& opts,
@@ -543,6 +1157,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_allgather_base_(a
                                                                                const AllgatherOptions& opts,
                                                                                ProcessGroupCCL& pg_ccl) {
   const int world_size = pg_ccl.getSize();
+  const int rank = pg_ccl.getRank();
   if (inputTensor.numel() * world_size != outputTensor.numel()) {
     TORCH_CHECK(false, "output tensor size must be equal to world_size times input tensor size");
   }
@@ -551,6 +1166,13 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_allgather_base_(a
   auto inputs = std::vector<at::Tensor> {inputTensor};
   auto outputs = std::vector<at::Tensor> {outputTensor};
 
+  if (use_quantized_allgather(pg_ccl, inputs, outputs)) {
+    return _allgather_quantized(outputs, inputs, c10d::OpType::_ALLGATHER_BASE, pg_ccl);
+  }
+  if (use_lossless_compression(pg_ccl, inputs, outputs)) {
+    return _allgather_lossless(outputs, inputs, c10d::OpType::_ALLGATHER_BASE, pg_ccl);
+  }
+
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
   work = collective<get_ccl_comms, CPUWorkCCL>(
           pg_ccl,
@@ -561,23 +1183,355 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_allgather_base_(a
               ccl::allgatherv_attr attr,
               ccl::communicator& comm) {
             RECORD_FUNCTION("oneccl_bindings_for_pytorch::cpu::_allgather_base", std::vector<c10::IValue>({input}));
+            return allgather_into_tensor(input, output, rank, world_size, attr, comm);
+          },
+          c10d::OpType::_ALLGATHER_BASE);
+  work->debugName = std::string("cpu::_allgather_base");
+  enqueue(work);
+  return work;
+}
+
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::allgather_into_tensor_coalesced_(std::vector<at::Tensor>& outputTensors,
+                                                                                               std::vector<at::Tensor>& inputTensors,
+                                                                                               const AllgatherOptions& opts,
+                                                                                               ProcessGroupCCL& pg_ccl) {
+  const int world_size = pg_ccl.getSize();
+  const int rank = pg_ccl.getRank();
+  TORCH_CHECK(inputTensors.size() == outputTensors.size(),
+              "allgather_into_tensor_coalesced: number of input and output tensors doesn't match");
+  for (const auto i : c10::irange(inputTensors.size())) {
+    checkSameTypeOrCastable(inputTensors[i], {outputTensors[i]});
+    if (inputTensors[i].numel() * world_size != outputTensors[i].numel()) {
+      TORCH_CHECK(false, "output tensor size must be equal to world_size times input tensor size");
+    }
+  }
+
+  if (use_quantized_allgather(pg_ccl, inputTensors, outputTensors)) {
+    return _allgather_quantized(outputTensors, inputTensors, c10d::OpType::COALESCED, pg_ccl);
+  }
+  if (use_lossless_compression(pg_ccl, inputTensors, outputTensors)) {
+    return _allgather_lossless(outputTensors, inputTensors, c10d::OpType::COALESCED, pg_ccl);
+  }
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg_ccl,
+          inputTensors,
+          outputTensors,
+          [=](at::Tensor input,
+              at::Tensor output,
+              ccl::allgatherv_attr attr,
+              ccl::communicator& comm) {
+            RECORD_FUNCTION("oneccl_bindings_for_pytorch::cpu::allgather_into_tensor_coalesced", std::vector<c10::IValue>({input}));
+            return allgather_into_tensor(input, output, rank, world_size, attr, comm);
+          },
+          c10d::OpType::COALESCED,
+          "oneccl_bindings_for_pytorch::cpu_work::allgather_into_tensor_coalesced");
+  work->debugName = std::string("cpu::allgather_into_tensor_coalesced");
+  enqueue(work);
+  return work;
+}
 
-            std::vector<size_t> recvCounts(world_size, input.numel());
+// _allgather_quantized gathers block-quantized shards. The shards are split in
+// chunks of whole blocks: a chunk is sent while the next one is quantized, and
+// dequantized into the outputs by the completion hook as soon as it is received.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_allgather_quantized(std::vector<at::Tensor>& outputTensors,
+                                                                                   std::vector<at::Tensor>& inputTensors,
+                                                                                   c10d::OpType opType,
+                                                                                   ProcessGroupCCL& pg_ccl) {
+  const int world_size = pg_ccl.getSize();
+  const int bits = pg_ccl.allgatherQuantBits_;
+  const int64_t blockSize = pg_ccl.allgatherQuantBlockSize_;
+  const int64_t chunkNumel =
+      std::max<int64_t>(1, kQuantChunkBytes / quantized_block_bytes(bits, blockSize)) * blockSize;
+
+  struct QuantChunk {
+    at::Tensor output;
+    int64_t shardNumel;
+    int64_t offset;
+    int64_t numel;
+    at::Tensor sendBuf;
+    at::Tensor recvBuf;
+  };
+  auto chunks = std::make_shared<std::vector<QuantChunk>>();
+  std::vector<at::Tensor> chunkInputs;
+  std::vector<at::Tensor> chunkOutputs;
+  for (const auto i : c10::irange(inputTensors.size())) {
+    auto input = inputTensors[i].view({-1});
+    auto byteOptions = input.options().dtype(at::kByte);
+    const int64_t shardNumel = input.numel();
+    for (int64_t offset = 0; offset < shardNumel; offset += chunkNumel) {
+      const int64_t numel = std::min(chunkNumel, shardNumel - offset);
+      const int64_t bytes = quantized_nbytes(numel, bits, blockSize);
+      chunks->push_back({outputTensors[i], shardNumel, offset, numel,
+                         at::empty({bytes}, byteOptions),
+                         at::empty({world_size * bytes}, byteOptions)});
+      chunkInputs.push_back(input.narrow(0, offset, numel));
+      chunkOutputs.push_back(outputTensors[i]);
+    }
+  }
+
+  RunIndex nextChunk;
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg_ccl,
+          chunkInputs,
+          chunkOutputs,
+          [=](at::Tensor input,
+              at::Tensor /*output*/,
+              ccl::allgatherv_attr attr,
+              ccl::communicator& comm) {
+            RECORD_FUNCTION("oneccl_bindings_for_pytorch::cpu::allgather_quantized", std::vector<c10::IValue>({input}));
+            auto& chunk = (*chunks)[nextChunk()];
+            quantize_blockwise(input, chunk.sendBuf, bits, blockSize);
 
+            std::vector<size_t> recvCounts(world_size, chunk.sendBuf.numel());
             ccl::event ret_evt;
             call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
-              CCL_CHECK(ret_evt = ccl::allgatherv(input.data_ptr(),
-                                                  (size_t) input.numel(),
-                                                  output.data_ptr(),
+              CCL_CHECK(ret_evt = ccl::allgatherv(chunk.sendBuf.data_ptr(),
+                                                  (size_t) chunk.sendBuf.numel(),
+                                                  chunk.recvBuf.data_ptr(),
                                                   recvCounts,
-                                                  cclDatatypes.at(input.scalar_type()),
+                                                  ccl::datatype::uint8,
                                                   comm,
                                                   attr));
             });
             return ret_evt;
           },
-          c10d::OpType::_ALLGATHER_BASE);
-  work->debugName = std::string("cpu::_allgather_base");
+          opType,
+          "oneccl_bindings_for_pytorch::cpu_work::allgather_quantized");
+
+  work->completionHook = [chunks, world_size, bits, blockSize](size_t i) {
+    const auto& chunk = (*chunks)[i];
+    auto output = chunk.output.view({-1});
+    const int64_t bytes = chunk.sendBuf.numel();
+    for (const auto r : c10::irange(world_size)) {
+      dequantize_blockwise(chunk.recvBuf.narrow(0, r * bytes, bytes),
+                           output.narrow(0, r * chunk.shardNumel + chunk.offset, chunk.numel),
+                           bits,
+                           blockSize);
+    }
+  };
+  work->debugName = std::string("cpu::allgather_quantized");
+  enqueue(work);
+  return work;
+}
+
+// _allgather_lossless gathers losslessly compressed shards. The compressed
+// sizes differ between the ranks, so they are exchanged by a small allgather
+// per batch of chunks before the chunks of the batch are gathered, each by
+// its own allgatherv. The next batch is compressed and its sizes exchanged
+// while the current one is in flight, and the completion hook decompresses
+// each chunk into the outputs as soon as it is received.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_allgather_lossless(std::vector<at::Tensor>& outputTensors,
+                                                                                  std::vector<at::Tensor>& inputTensors,
+                                                                                  c10d::OpType opType,
+                                                                                  ProcessGroupCCL& pg_ccl) {
+  const int world_size = pg_ccl.getSize();
+  auto chunks = lossless_chunks(inputTensors, outputTensors);
+  auto batches = std::make_shared<std::vector<LosslessBatch>>(
+          (chunks->size() + kLosslessBatchChunks - 1) / kLosslessBatchChunks);
+  std::vector<at::Tensor> chunkInputs;
+  std::vector<at::Tensor> chunkOutputs;
+  for (const auto& chunk : *chunks) {
+    chunkInputs.push_back(chunk.input);
+    chunkOutputs.push_back(chunk.output);
+  }
+
+  // Compresses the chunks of batch b and starts the exchange of their sizes.
+  auto exchangeSizes = [chunks, batches, world_size](size_t b, ccl::communicator& comm) {
+    const auto range = lossless_batch_range(*chunks, b);
+    const int64_t count = range.second - range.first;
+    lossless_encode_chunks(*chunks, range.first, range.second);
+    auto& batch = (*batches)[b];
+    // This rank's sizes, followed by the sizes of all the ranks.
+    batch.sizes = at::empty({(world_size + 1) * count}, at::kLong);
+    auto sizes = batch.sizes.data_ptr<int64_t>();
+    for (const auto c : c10::irange(count)) {
+      sizes[c] = (*chunks)[range.first + c].sendBytes;
+    }
+    std::vector<size_t> counts(world_size, count);
+    call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+      CCL_CHECK(batch.event = ccl::allgatherv(sizes,
+                                              (size_t) count,
+                                              sizes + count,
+                                              counts,
+                                              ccl::datatype::int64,
+                                              comm,
+                                              ccl::create_operation_attr<ccl::allgatherv_attr>()));
+    });
+  };
+
+  // The chunks are issued in order, one call of the run function per chunk,
+  // so the size exchanges and the chunks are in the same order on all ranks.
+  RunIndex nextChunk;
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg_ccl,
+          chunkInputs,
+          chunkOutputs,
+          [=](at::Tensor input,
+              at::Tensor /*output*/,
+              ccl::allgatherv_attr attr,
+              ccl::communicator& comm) {
+            RECORD_FUNCTION("oneccl_bindings_for_pytorch::cpu::allgather_lossless", std::vector<c10::IValue>({input}));
+            const size_t c = nextChunk();
+            const size_t b = c / kLosslessBatchChunks;
+            if (c == 0) {
+              exchangeSizes(0, comm);
+            }
+            const auto range = lossless_batch_range(*chunks, b);
+            if (c == range.first) {
+              auto& batch = (*batches)[b];
+              CCL_CHECK(batch.event.wait());
+              const int64_t count = range.second - range.first;
+              auto all = batch.sizes.data_ptr<int64_t>() + count;
+              for (const auto k : c10::irange(count)) {
+                auto& chunk = (*chunks)[range.first + k];
+                int64_t total = 0;
+                for (const auto r : c10::irange(world_size)) {
+                  chunk.recvCounts.push_back(all[r * count + k]);
+                  chunk.recvOffsets.push_back(total);
+                  total += all[r * count + k];
+                }
+                chunk.recvBuf = at::empty({total}, chunk.sendBuf.options());
+              }
+            }
+            auto& chunk = (*chunks)[c];
+
+            ccl::event ret_evt;
+            call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+              CCL_CHECK(ret_evt = ccl::allgatherv(chunk.sendBuf.data_ptr(),
+                                                  (size_t) chunk.sendBytes,
+                                                  chunk.recvBuf.data_ptr(),
+                                                  chunk.recvCounts,
+                                                  ccl::datatype::uint8,
+                                                  comm,
+                                                  attr));
+            });
+            if (c + 1 == range.second && b + 1 < batches->size()) {
+              exchangeSizes(b + 1, comm);
+            }
+            return ret_evt;
+          },
+          opType,
+          "oneccl_bindings_for_pytorch::cpu_work::allgather_lossless");
+
+  work->completionHook = [chunks, world_size](size_t i) {
+    auto& chunk = (*chunks)[i];
+    auto recv = chunk.recvBuf.data_ptr<uint8_t>();
+    auto output = static_cast<uint8_t*>(chunk.output.data_ptr());
+    at::parallel_for(0, world_size, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; ++r) {
+        lossless_decode(recv + chunk.recvOffsets[r],
+                        chunk.recvCounts[r],
+                        output + r * chunk.shardBytes + chunk.offset,
+                        chunk.bytes,
+                        chunk.elementSize);
+      }
+    });
+    chunk.sendBuf.reset();
+    chunk.recvBuf.reset();
+  };
+  work->debugName = std::string("cpu::allgather_lossless");
+  enqueue(work);
+  return work;
+}
+
+// _broadcast_lossless broadcasts the losslessly compressed chunks of the
+// tensor of the root. The root broadcasts the compressed sizes of each batch
+// of chunks before the chunks themselves, and compresses the next batch while
+// the current one is in flight. The other ranks decompress each chunk as soon
+// as it is received.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_broadcast_lossless(std::vector<at::Tensor>& tensors,
+                                                                                  const BroadcastOptions& opts,
+                                                                                  ProcessGroupCCL& pg) {
+  const bool isRoot = pg.getRank() == opts.rootRank;
+  auto chunks = lossless_chunks(tensors, tensors);
+  auto batches = std::make_shared<std::vector<LosslessBatch>>(
+          (chunks->size() + kLosslessBatchChunks - 1) / kLosslessBatchChunks);
+  std::vector<at::Tensor> chunkTensors(chunks->size(), tensors[0]);
+
+  // Compresses the chunks of batch b on the root and starts the broadcast of
+  // their sizes.
+  auto exchangeSizes = [chunks, batches, isRoot, root = opts.rootRank](size_t b, ccl::communicator& comm) {
+    const auto range = lossless_batch_range(*chunks, b);
+    const int64_t count = range.second - range.first;
+    auto& batch = (*batches)[b];
+    batch.sizes = at::empty({count}, at::kLong);
+    if (isRoot) {
+      lossless_encode_chunks(*chunks, range.first, range.second);
+      for (const auto c : c10::irange(count)) {
+        batch.sizes.data_ptr<int64_t>()[c] = (*chunks)[range.first + c].sendBytes;
+      }
+    }
+    call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+      CCL_CHECK(batch.event = ccl::broadcast(batch.sizes.data_ptr(),
+                                             (size_t) count,
+                                             ccl::datatype::int64,
+                                             (size_t) root,
+                                             comm));
+    });
+  };
+
+  RunIndex nextChunk;
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg,
+          chunkTensors,
+          chunkTensors,
+          [=](at::Tensor input,
+              at::Tensor /*output*/,
+              ccl::broadcast_attr attr,
+              ccl::communicator& comm) {
+            RECORD_FUNCTION("oneccl_bindings_for_pytorch::cpu::broadcast_lossless", std::vector<c10::IValue>({input}));
+            const size_t c = nextChunk();
+            const size_t b = c / kLosslessBatchChunks;
+            if (c == 0) {
+              exchangeSizes(0, comm);
+            }
+            const auto range = lossless_batch_range(*chunks, b);
+            if (c == range.first) {
+              auto& batch = (*batches)[b];
+              CCL_CHECK(batch.event.wait());
+              if (!isRoot) {
+                for (const auto k : c10::irange(range.second - range.first)) {
+                  auto& chunk = (*chunks)[range.first + k];
+                  chunk.sendBytes = batch.sizes.data_ptr<int64_t>()[k];
+                  chunk.sendBuf = at::empty({chunk.sendBytes}, chunk.input.options().dtype(at::kByte));
+                }
+              }
+            }
+            auto& chunk = (*chunks)[c];
+
+            ccl::event ret_evt;
+            call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+              CCL_CHECK(ret_evt = ccl::broadcast(chunk.sendBuf.data_ptr(),
+                                                 (size_t) chunk.sendBytes,
+                                                 ccl::datatype::uint8,
+                                                 (size_t) opts.rootRank,
+                                                 comm));
+            });
+            if (c + 1 == range.second && b + 1 < batches->size()) {
+              exchangeSizes(b + 1, comm);
+            }
+            return ret_evt;
+          },
+          c10d::OpType::BROADCAST,
+          "oneccl_bindings_for_pytorch::cpu_work::broadcast_lossless");
+
+  work->completionHook = [chunks, isRoot](size_t i) {
+    auto& chunk = (*chunks)[i];
+    if (!isRoot) {
+      lossless_decode(chunk.sendBuf.data_ptr<uint8_t>(),
+                      chunk.sendBytes,
+                      static_cast<uint8_t*>(chunk.output.data_ptr()) + chunk.offset,
+                      chunk.bytes,
+                      chunk.elementSize);
+    }
+    chunk.sendBuf.reset();
+  };
+  work->debugName = std::string("cpu::broadcast_lossless");
   enqueue(work);
   return work;
 }
@@ -627,7 +1581,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::gather_(std::vecto
                         CCL_CHECK(ret_evt = ccl::recv(outputs[r].data_ptr(), count, type, r, comm));
                     } else {
                         // on its own rank, simply copy from the input
-                        outputs[r].copy_(input);
+                        staging_copy_(outputs[r], input);
                     }
                 }
             } else {
@@ -656,9 +1610,11 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::reduce_scatter_(st
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
   if (same_size) {
     auto inputFlattened = newLikeFlat(inputTensors_);
+    std::vector<at::Tensor> flattenedSlices;
     for (const auto j : c10::irange(inputTensors_.size())) {
-        inputFlattened[j].copy_(inputTensors_[j], true);
+        flattenedSlices.push_back(inputFlattened[j]);
     }
+    staging_copy_(flattenedSlices, inputTensors_, /*to_staging=*/true);
     std::vector<at::Tensor> flattendInputTensors{inputFlattened};
     work = collective<get_ccl_comms, CPUWorkCCL>(
             pg_ccl,
@@ -675,7 +1631,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::reduce_scatter_(st
                                                         output.data_ptr(),
                                                         (size_t) output.numel(),
                                                         cclDatatypes.at(input.scalar_type()),
-                                                        cclOps.at(opts.reduceOp),
+                                                        get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                                         comm));
                 });
                 return ret_evt;
@@ -753,7 +1709,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::scatter_(std::vect
                         CCL_CHECK(ret_evt = ccl::send(inputs[r].data_ptr(), send_count, send_type, r, comm));
                     } else {
                         // on its own rank, simply copy from the input
-                        output.copy_(inputs[r]);
+                        staging_copy_(output, inputs[r]);
                     }
                 }
             } else {
@@ -782,15 +1738,19 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_reduce_scatter_ba
   checkSingleTensorHelper(inputTensor);
   checkSingleTensorHelper(outputTensor);
   int size = pg.getSize();
-  if (inputTensor.dtype() != outputTensor.dtype()) {
-    TORCH_CHECK(false, "output tensor must have the same type as input tensor");
-  }
-
   if (outputTensor.numel() * size != inputTensor.numel()) {
     TORCH_CHECK(
         false,
         "input tensor size must be equal to world_size times output tensor size");
   }
+
+  if (inputTensor.dtype() != outputTensor.dtype()) {
+    TORCH_CHECK(at::isFloatingType(inputTensor.scalar_type()) &&
+                at::isFloatingType(outputTensor.scalar_type()) &&
+                c10::elementSize(outputTensor.scalar_type()) > c10::elementSize(inputTensor.scalar_type()),
+                "output tensor must have the same type as input tensor, or a wider floating point type");
+    return _reduce_scatter_base_upcast(outputTensor, inputTensor, opts, pg);
+  }
   std::vector<at::Tensor> inputs{inputTensor};
   std::vector<at::Tensor> outputs{outputTensor};
 
@@ -810,7 +1770,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_reduce_scatter_ba
                                                 output.data_ptr(),
                                                 size_t(input.numel()/size),
                                                 cclDatatypes.at(input.scalar_type()),
-                                                cclOps.at(opts.reduceOp),
+                                                get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                                 comm,
                                                 attr););
         });
@@ -825,6 +1785,69 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_reduce_scatter_ba
   return work;
 }
 
+// _reduce_scatter_base_upcast reduces a low precision input into a wider output.
+// The shards are exchanged with an alltoall in the input type and accumulated in
+// the output type on receipt: the traffic stays in the low precision while none
+// of the partial sums is rounded to it.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_reduce_scatter_base_upcast(at::Tensor& outputTensor,
+                                                                                          at::Tensor& inputTensor,
+                                                                                          const ReduceScatterOptions& opts,
+                                                                                          ProcessGroupCCL& pg) {
+  const auto reduceOp = opts.reduceOp;
+  TORCH_CHECK(reduceOp == ReduceOp::SUM || reduceOp == ReduceOp::PRODUCT ||
+              reduceOp == ReduceOp::MIN || reduceOp == ReduceOp::MAX,
+              "_reduce_scatter_base: unsupported reduce op for mixed precision tensors");
+
+  const int size = pg.getSize();
+  auto recvBuf = at::empty({size, outputTensor.numel()}, inputTensor.options());
+  std::vector<at::Tensor> inputs{inputTensor};
+  std::vector<at::Tensor> outputs{outputTensor};
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+    pg,
+    inputs,
+    outputs,
+    [=](at::Tensor input,
+        at::Tensor output,
+        ccl::alltoall_attr attr,
+        ccl::communicator& comm) {
+        ccl::event ret_evt;
+
+        call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&](){
+            CCL_CHECK(ret_evt = ccl::alltoall(input.data_ptr(),
+                                              recvBuf.data_ptr(),
+                                              (size_t) output.numel(),
+                                              cclDatatypes.at(input.scalar_type()),
+                                              comm,
+                                              attr););
+        });
+
+        return ret_evt;
+      },
+    c10d::OpType::_REDUCE_SCATTER_BASE,
+    "oneccl_bindings_for_pytorch::cpu_work::_reduce_scatter_base");
+
+  work->completionHook = [recvBuf, outputTensor, reduceOp](size_t) {
+    auto output = outputTensor.view({-1});
+    output.copy_(recvBuf[0]);
+    for (const auto r : c10::irange(1, recvBuf.size(0))) {
+      if (reduceOp == ReduceOp::SUM) {
+        output.add_(recvBuf[r]);
+      } else if (reduceOp == ReduceOp::PRODUCT) {
+        output.mul_(recvBuf[r]);
+      } else if (reduceOp == ReduceOp::MIN) {
+        at::minimum_out(output, output, recvBuf[r]);
+      } else {
+        at::maximum_out(output, output, recvBuf[r]);
+      }
+    }
+  };
+  work->debugName = std::string("cpu::_reduce_scatter_base");
+  enqueue(work);
+  return work;
+}
+
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::alltoall_base_(at::Tensor& outputTensor,
                                                              at::Tensor& inputTensor,
                                                              std::vector<int64_t>& outputSplitSizes,
@@ -963,10 +1986,12 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::alltoall_(std::vec
               flatInput.split_with_sizes(c10::IntArrayRef((int64_t*)sendCounts.data(),
                                          sendCounts.size()), 0);
 
+          std::vector<at::Tensor> flatInputs;
           for (int i = 0; i < grp_size; i++)
           {
-              flatInputSplits[i].copy_(inputs[i].view({-1}));
+              flatInputs.push_back(inputs[i].view({-1}));
           }
+          staging_copy_(flatInputSplits, flatInputs, /*to_staging=*/true);
       }
 
       ccl::event ret_evt;
@@ -989,10 +2014,12 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::alltoall_(std::vec
              flatOutput.split_with_sizes(c10::IntArrayRef((int64_t*)recvCounts.data(),
                                          recvCounts.size()), 0);
 
+         std::vector<at::Tensor> flatOutputs;
          for (int i = 0; i < grp_size; i++)
          {
-             outputs[i].view({-1}).copy_(flatOutputSplits[i]);
+             flatOutputs.push_back(outputs[i].view({-1}));
          }
+         staging_copy_(flatOutputs, flatOutputSplits);
       }
       return ret_evt;
   },
@@ -1004,18 +2031,170 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::alltoall_(std::vec
   return work;
 }
 
+// _p2p builds a send or recv work on the communicator of the group, as
+// scatter_ does. A point-to-point op may wait for a matching op which the peer
+// posts after it, so it is not throttled by the inflight limits.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::_p2p(std::vector<at::Tensor>& tensors,
+                                                                int peer,
+                                                                bool isSend,
+                                                                ProcessGroupCCL& pg) {
+  TORCH_CHECK(peer >= 0 && peer < pg.getSize() && peer != pg.getRank(),
+              "invalid peer rank ", peer, " for rank ", pg.getRank(), " of ", pg.getSize());
+  for (const auto& tensor : tensors) {
+    checkSingleTensorHelper(tensor);
+  }
+
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg,
+          tensors,
+          tensors,
+          [=](at::Tensor tensor,
+              at::Tensor /*output*/,
+              ccl::pt2pt_attr attr,
+              ccl::communicator& comm) {
+            ccl::event ret_evt;
+            call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+              if (isSend) {
+                CCL_CHECK(ret_evt = ccl::send(tensor.data_ptr(),
+                                              (size_t) tensor.numel(),
+                                              cclDatatypes.at(tensor.scalar_type()),
+                                              peer,
+                                              comm,
+                                              attr));
+              } else {
+                CCL_CHECK(ret_evt = ccl::recv(tensor.data_ptr(),
+                                              (size_t) tensor.numel(),
+                                              cclDatatypes.at(tensor.scalar_type()),
+                                              peer,
+                                              comm,
+                                              attr));
+              }
+            });
+            return ret_evt;
+          },
+          isSend ? c10d::OpType::SEND : c10d::OpType::RECV,
+          isSend ? "oneccl_bindings_for_pytorch::cpu_work::send" : "oneccl_bindings_for_pytorch::cpu_work::recv");
+  work->inflightLimiter_.reset();
+  work->debugName = std::string(isSend ? "cpu::send" : "cpu::recv");
+  return work;
+}
+
+// The tags are ignored, as on XPU: the messages between two ranks are
+// matched in the order they are posted.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::send_(std::vector<at::Tensor>& tensors,
+                                                                 int dstRank,
+                                                                 int /* unused */,
+                                                                 ProcessGroupCCL& pg) {
+  auto work = _p2p(tensors, dstRank, true, pg);
+  enqueueP2P(work);
+  return work;
+}
+
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::recv_(std::vector<at::Tensor>& tensors,
+                                                                 int srcRank,
+                                                                 int /* unused */,
+                                                                 ProcessGroupCCL& pg) {
+  auto work = _p2p(tensors, srcRank, false, pg);
+  enqueueP2P(work);
+  return work;
+}
+
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::prepost_recv_(std::vector<at::Tensor>& tensors,
+                                                                         int srcRank,
+                                                                         ProcessGroupCCL& pg) {
+  auto work = _p2p(tensors, srcRank, false, pg);
+  work->run();
+  return work;
+}
+
+// ring_exchange_ issues one oneCCL send or recv per tensor on the communicator
+// of the group, all in a single work: the receives first, then the sends, so
+// that every rank has posted its receives before a send waits for a match.
+// With 2 ranks, the previous and next rank are the same peer and the messages
+// are matched in the order they are posted, which is the same on both ranks.
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::ring_exchange_(std::vector<at::Tensor>& sendToNext,
+                                                                          std::vector<at::Tensor>& recvFromPrev,
+                                                                          std::vector<at::Tensor>& sendToPrev,
+                                                                          std::vector<at::Tensor>& recvFromNext,
+                                                                          ProcessGroupCCL& pg) {
+  const int size = pg.getSize();
+  const int next = (pg.getRank() + 1) % size;
+  const int prev = (pg.getRank() + size - 1) % size;
+
+  struct RingOp {
+    int peer;
+    bool isSend;
+  };
+  auto ops = std::make_shared<std::vector<RingOp>>();
+  std::vector<at::Tensor> tensors;
+  auto add = [&](std::vector<at::Tensor>& list, int peer, bool isSend) {
+    for (auto& tensor : list) {
+      ops->push_back({peer, isSend});
+      tensors.push_back(tensor);
+    }
+  };
+  add(recvFromPrev, prev, false);
+  add(recvFromNext, next, false);
+  add(sendToNext, next, true);
+  add(sendToPrev, prev, true);
+
+  RunIndex nextOp;
+  c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
+  work = collective<get_ccl_comms, CPUWorkCCL>(
+          pg,
+          tensors,
+          tensors,
+          [=](at::Tensor tensor,
+              at::Tensor /*output*/,
+              ccl::pt2pt_attr attr,
+              ccl::communicator& comm) {
+            const auto& op = (*ops)[nextOp()];
+            ccl::event ret_evt;
+            call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
+              if (op.isSend) {
+                CCL_CHECK(ret_evt = ccl::send(tensor.data_ptr(),
+                                              (size_t) tensor.numel(),
+                                              cclDatatypes.at(tensor.scalar_type()),
+                                              op.peer,
+                                              comm,
+                                              attr));
+              } else {
+                CCL_CHECK(ret_evt = ccl::recv(tensor.data_ptr(),
+                                              (size_t) tensor.numel(),
+                                              cclDatatypes.at(tensor.scalar_type()),
+                                              op.peer,
+                                              comm,
+                                              attr));
+              }
+            });
+            return ret_evt;
+          },
+          c10d::OpType::UNKNOWN,
+          "oneccl_bindings_for_pytorch::cpu_work::ring_exchange");
+
+  work->debugName = std::string("cpu::ring_exchange");
+  enqueue(work);
+  return work;
+}
+
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> VanillaCPU::barrier_(const BarrierOptions& opts,
                                                                    ProcessGroupCCL& pg) {
 
+  TORCH_CHECK(!pg.aborted(), "The process group was aborted");
+  pg.checkNoChainInFlight();
   c10::intrusive_ptr<AsyncBarrierWork> work = c10::make_intrusive<AsyncBarrierWork>();
 
-  if (pg.ccl_member_->ccl_comms.size() == 0) {
+  auto member = pg.cclMember();
+  if (member->ccl_comms.size() == 0) {
     std::vector<at::Device> cpu_devices{at::Device("cpu")};
     const auto key = get_key_from_devs(cpu_devices);
     get_ccl_comms(pg, key, cpu_devices);
   }
 
-  auto& comms_map = pg.ccl_member_->ccl_comms;
+  auto& comms_map = member->ccl_comms;
+  work->groupAborted_ = pg.groupAborted_;
+  work->markStarted();
   for(auto iter = comms_map.begin(); iter != comms_map.end(); iter++){
       for(size_t i =0 ; i < iter->second->comms.size(); i++){
          work->getEvents().emplace_back(
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "lossless.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace oneccl_bindings_for_pytorch {
+
+namespace {
+
+enum Mode : uint8_t {
+  kStored = 0,
+  kShuffled = 1,
+  kDeltaShuffled = 2,
+};
+
+// Shorter runs of zeros stay in the literals, their token would not pay off.
+constexpr int64_t kMinZeroRun = 4;
+// Bytes of the shuffled planes looked at to skip the incompressible chunks.
+constexpr int64_t kSampleBytes = 4096;
+
+std::vector<uint8_t>& scratch(int64_t nbytes) {
+  thread_local std::vector<uint8_t> buffer;
+  if ((int64_t) buffer.size() < nbytes) {
+    buffer.resize(nbytes);
+  }
+  return buffer;
+}
+
+template <typename T>
+void shuffle(const uint8_t* src, int64_t numel, bool delta, uint8_t* dst) {
+  T prev = 0;
+  for (int64_t i = 0; i < numel; ++i) {
+    T value;
+    std::memcpy(&value, src + i * sizeof(T), sizeof(T));
+    T word = delta ? static_cast<T>(value - prev) : value;
+    prev = value;
+    for (size_t b = 0; b < sizeof(T); ++b) {
+      dst[b * numel + i] = static_cast<uint8_t>(word >> (8 * b));
+    }
+  }
+}
+
+template <typename T>
+void unshuffle(const uint8_t* src, int64_t numel, bool delta, uint8_t* dst) {
+  T prev = 0;
+  for (int64_t i = 0; i < numel; ++i) {
+    T word = 0;
+    for (size_t b = 0; b < sizeof(T); ++b) {
+      word |= static_cast<T>(static_cast<T>(src[b * numel + i]) << (8 * b));
+    }
+    T value = delta ? static_cast<T>(prev + word) : word;
+    prev = value;
+    std::memcpy(dst + i * sizeof(T), &value, sizeof(T));
+  }
+}
+
+void shuffle_bytes(const uint8_t* src, int64_t nbytes, int64_t element_size, bool delta, uint8_t* dst) {
+  const int64_t numel = nbytes / element_size;
+  switch (element_size) {
+    case 1:
+      shuffle<uint8_t>(src, numel, delta, dst);
+      return;
+    case 2:
+      shuffle<uint16_t>(src, numel, delta, dst);
+      return;
+    case 4:
+      shuffle<uint32_t>(src, numel, delta, dst);
+      return;
+    case 8:
+      shuffle<uint64_t>(src, numel, delta, dst);
+      return;
+  }
+  for (int64_t i = 0; i < numel; ++i) {
+    for (int64_t b = 0; b < element_size; ++b) {
+      dst[b * numel + i] = src[i * element_size + b];
+    }
+  }
+}
+
+void unshuffle_bytes(const uint8_t* src, int64_t nbytes, int64_t element_size, bool delta, uint8_t* dst) {
+  const int64_t numel = nbytes / element_size;
+  switch (element_size) {
+    case 1:
+      unshuffle<uint8_t>(src, numel, delta, dst);
+      return;
+    case 2:
+      unshuffle<uint16_t>(src, numel, delta, dst);
+      return;
+    case 4:
+      unshuffle<uint32_t>(src, numel, delta, dst);
+      return;
+    case 8:
+      unshuffle<uint64_t>(src, numel, delta, dst);
+      return;
+  }
+  for (int64_t i = 0; i < numel; ++i) {
+    for (int64_t b = 0; b < element_size; ++b) {
+      dst[i * element_size + b] = src[b * numel + i];
+    }
+  }
+}
+
+// Tokens are varints of (length << 1 | zero run), a literal token is followed
+// by its bytes. Returns the encoded size, or -1 if it would exceed limit.
+int64_t zero_rle_encode(const uint8_t* src, int64_t n, uint8_t* dst, int64_t limit) {
+  int64_t out = 0;
+  auto put = [&](uint64_t v) {
+    while (v >= 0x80) {
+      if (out >= limit)
+        return false;
+      dst[out++] = static_cast<uint8_t>(v) | 0x80;
+      v >>= 7;
+    }
+    if (out >= limit)
+      return false;
+    dst[out++] = static_cast<uint8_t>(v);
+    return true;
+  };
+  auto literals = [&](int64_t begin, int64_t end) {
+    if (begin == end)
+      return true;
+    if (!put(static_cast<uint64_t>(end - begin) << 1) || out + (end - begin) > limit)
+      return false;
+    std::memcpy(dst + out, src + begin, end - begin);
+    out += end - begin;
+    return true;
+  };
+
+  int64_t literal = 0;
+  int64_t i = 0;
+  while (i < n) {
+    auto zero = static_cast<const uint8_t*>(std::memchr(src + i, 0, n - i));
+    if (zero == nullptr)
+      break;
+    i = zero - src;
+    int64_t j = i;
+    while (j + 8 <= n) {
+      uint64_t word;
+      std::memcpy(&word, src + j, 8);
+      if (word != 0)
+        break;
+      j += 8;
+    }
+    while (j < n && src[j] == 0)
+      ++j;
+    if (j - i >= kMinZeroRun) {
+      if (!literals(literal, i) || !put((static_cast<uint64_t>(j - i) << 1) | 1))
+        return -1;
+      literal = j;
+    }
+    i = j;
+  }
+  if (!literals(literal, n))
+    return -1;
+  return out;
+}
+
+void zero_rle_decode(const uint8_t* src, int64_t src_bytes, uint8_t* dst, int64_t n) {
+  int64_t in = 0;
+  int64_t out = 0;
+  while (in < src_bytes) {
+    uint64_t v = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+      TORCH_CHECK(in < src_bytes && shift < 64, "corrupted compressed chunk");
+      byte = src[in++];
+      v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    const int64_t len = static_cast<int64_t>(v >> 1);
+    TORCH_CHECK(len <= n - out, "corrupted compressed chunk");
+    if (v & 1) {
+      std::memset(dst + out, 0, len);
+    } else {
+      TORCH_CHECK(len <= src_bytes - in, "corrupted compressed chunk");
+      std::memcpy(dst + out, src + in, len);
+      in += len;
+    }
+    out += len;
+  }
+  TORCH_CHECK(out == n, "corrupted compressed chunk");
+}
+
+} // namespace
+
+int64_t lossless_bound(int64_t nbytes) {
+  return nbytes + 1;
+}
+
+bool lossless_use_delta(at::ScalarType type) {
+  return at::isIntegralType(type, /*includeBool=*/true);
+}
+
+int64_t lossless_encode(const uint8_t* src, int64_t nbytes, int64_t element_size, bool delta, uint8_t* dst) {
+  TORCH_CHECK(element_size > 0 && nbytes % element_size == 0, "the chunk must hold whole elements");
+  auto& shuffled = scratch(nbytes);
+  shuffle_bytes(src, nbytes, element_size, delta, shuffled.data());
+
+  // Without enough zero bytes in a sample of the planes, the chunk will not
+  // shrink: store it without trying.
+  const int64_t stride = std::max<int64_t>(1, nbytes / kSampleBytes);
+  int64_t sampled = 0;
+  int64_t zeros = 0;
+  for (int64_t i = 0; i < nbytes; i += stride) {
+    zeros += shuffled[i] == 0;
+    ++sampled;
+  }
+  if (zeros * 8 >= sampled) {
+    // Worth it only if it saves at least 1/16 of the bytes.
+    int64_t encoded = zero_rle_encode(shuffled.data(), nbytes, dst + 1, nbytes - nbytes / 16);
+    if (encoded >= 0) {
+      dst[0] = delta ? kDeltaShuffled : kShuffled;
+      return encoded + 1;
+    }
+  }
+  dst[0] = kStored;
+  std::memcpy(dst + 1, src, nbytes);
+  return nbytes + 1;
+}
+
+void lossless_decode(const uint8_t* src, int64_t src_bytes, uint8_t* dst, int64_t nbytes, int64_t element_size) {
+  TORCH_CHECK(src_bytes >= 1, "corrupted compressed chunk");
+  if (src[0] == kStored) {
+    TORCH_CHECK(src_bytes == nbytes + 1, "corrupted compressed chunk");
+    std::memcpy(dst, src + 1, nbytes);
+    return;
+  }
+  TORCH_CHECK(src[0] == kShuffled || src[0] == kDeltaShuffled, "corrupted compressed chunk");
+  auto& shuffled = scratch(nbytes);
+  zero_rle_decode(src + 1, src_bytes - 1, shuffled.data(), nbytes);
+  unshuffle_bytes(shuffled.data(), nbytes, element_size, src[0] == kDeltaShuffled, dst);
+}
+
+} // namespace oneccl_bindings_for_pytorch
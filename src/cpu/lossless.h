@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <ATen/ATen.h>
+
+namespace oneccl_bindings_for_pytorch {
+
+// Lossless compression of low entropy payloads, such as masks, indices or
+// activations after a ReLU. The bytes of the elements are shuffled into
+// planes, the first byte of every element, then the second..., so that the
+// high bytes which are mostly zero line up, and the runs of zeros are
+// encoded by their length. Integer elements are delta encoded first.
+// Chunks which would not shrink enough are stored as is, behind the one
+// byte header which tells the decoder which encoding was used.
+
+// Largest encoded size of nbytes of data.
+int64_t lossless_bound(int64_t nbytes);
+
+// Whether the elements of this type are delta encoded.
+bool lossless_use_delta(at::ScalarType type);
+
+// Encodes nbytes, a whole number of elements of element_size bytes, into dst
+// of lossless_bound(nbytes) bytes and returns the encoded size.
+int64_t lossless_encode(const uint8_t* src, int64_t nbytes, int64_t element_size, bool delta, uint8_t* dst);
+
+// Decodes the src_bytes produced by lossless_encode into the nbytes of dst.
+void lossless_decode(const uint8_t* src, int64_t src_bytes, uint8_t* dst, int64_t nbytes, int64_t element_size);
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "quantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+
+namespace oneccl_bindings_for_pytorch {
+
+namespace {
+
+constexpr int64_t kScaleBytes = sizeof(float);
+
+int64_t ceil_div(int64_t a, int64_t b) {
+  return (a + b - 1) / b;
+}
+
+float quant_max(int bits) {
+  return bits == 8 ? 127.f : 7.f;
+}
+
+template <typename scalar_t>
+void quantize_kernel(const scalar_t* src, int64_t numel, uint8_t* dst, int bits, int64_t block_size) {
+  const int64_t num_blocks = ceil_div(numel, block_size);
+  const int64_t block_bytes = quantized_block_bytes(bits, block_size);
+  const float qmax = quant_max(bits);
+
+  at::parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      const scalar_t* in = src + b * block_size;
+      const int64_t len = std::min(block_size, numel - b * block_size);
+      uint8_t* out = dst + b * block_bytes;
+
+      float amax = 0.f;
+      for (int64_t i = 0; i < len; ++i) {
+        amax = std::max(amax, std::abs(static_cast<float>(in[i])));
+      }
+      const float scale = amax / qmax;
+      const float inv_scale = scale > 0.f ? 1.f / scale : 0.f;
+      std::memcpy(out, &scale, kScaleBytes);
+
+      uint8_t* q = out + kScaleBytes;
+      if (bits == 8) {
+        for (int64_t i = 0; i < len; ++i) {
+          float v = std::nearbyint(static_cast<float>(in[i]) * inv_scale);
+          q[i] = static_cast<uint8_t>(static_cast<int8_t>(std::min(std::max(v, -qmax), qmax)));
+        }
+      } else {
+        std::memset(q, 0, (len + 1) / 2);
+        for (int64_t i = 0; i < len; ++i) {
+          float v = std::nearbyint(static_cast<float>(in[i]) * inv_scale);
+          int nibble = static_cast<int>(std::min(std::max(v, -qmax), qmax)) & 0xF;
+          q[i / 2] |= static_cast<uint8_t>(nibble << ((i & 1) * 4));
+        }
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+void dequantize_kernel(const uint8_t* src, int64_t numel, scalar_t* dst, int bits, int64_t block_size) {
+  const int64_t num_blocks = ceil_div(numel, block_size);
+  const int64_t block_bytes = quantized_block_bytes(bits, block_size);
+
+  at::parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      const uint8_t* in = src + b * block_bytes;
+      const int64_t len = std::min(block_size, numel - b * block_size);
+      scalar_t* out = dst + b * block_size;
+
+      float scale;
+      std::memcpy(&scale, in, kScaleBytes);
+
+      const uint8_t* q = in + kScaleBytes;
+      if (bits == 8) {
+        for (int64_t i = 0; i < len; ++i) {
+          out[i] = static_cast<scalar_t>(static_cast<int8_t>(q[i]) * scale);
+        }
+      } else {
+        for (int64_t i = 0; i < len; ++i) {
+          // sign extend the 4 bits value
+          int nibble = (q[i / 2] >> ((i & 1) * 4)) & 0xF;
+          int v = nibble >= 8 ? nibble - 16 : nibble;
+          out[i] = static_cast<scalar_t>(v * scale);
+        }
+      }
+    }
+  });
+}
+
+} // namespace anonymous
+
+int64_t quantized_block_bytes(int bits, int64_t block_size) {
+  return kScaleBytes + ceil_div(block_size * bits, 8);
+}
+
+int64_t quantized_nbytes(int64_t numel, int bits, int64_t block_size) {
+  return ceil_div(numel, block_size) * quantized_block_bytes(bits, block_size);
+}
+
+void quantize_blockwise(const at::Tensor& src, const at::Tensor& dst, int bits, int64_t block_size) {
+  TORCH_CHECK(bits == 8 || bits == 4, "quantize_blockwise: only 8 and 4 bits are supported");
+  TORCH_CHECK(src.is_contiguous() && dst.is_contiguous(), "quantize_blockwise: tensors must be contiguous");
+  TORCH_CHECK(dst.scalar_type() == at::kByte && dst.numel() >= quantized_nbytes(src.numel(), bits, block_size),
+              "quantize_blockwise: destination buffer is too small");
+
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::kBFloat16, at::kHalf, src.scalar_type(), "quantize_blockwise", [&] {
+    quantize_kernel<scalar_t>(src.data_ptr<scalar_t>(), src.numel(), dst.data_ptr<uint8_t>(), bits, block_size);
+  });
+}
+
+void dequantize_blockwise(const at::Tensor& src, const at::Tensor& dst, int bits, int64_t block_size) {
+  TORCH_CHECK(bits == 8 || bits == 4, "dequantize_blockwise: only 8 and 4 bits are supported");
+  TORCH_CHECK(src.is_contiguous() && dst.is_contiguous(), "dequantize_blockwise: tensors must be contiguous");
+  TORCH_CHECK(src.scalar_type() == at::kByte && src.numel() >= quantized_nbytes(dst.numel(), bits, block_size),
+              "dequantize_blockwise: source buffer is too small");
+
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::kBFloat16, at::kHalf, dst.scalar_type(), "dequantize_blockwise", [&] {
+    dequantize_kernel<scalar_t>(src.data_ptr<uint8_t>(), dst.numel(), dst.data_ptr<scalar_t>(), bits, block_size);
+  });
+}
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "staging_copy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <dirent.h>
+#include <sched.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "../env.h"
+
+namespace oneccl_bindings_for_pytorch {
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+// Below this size, waking up the copy threads costs more than the copy itself.
+constexpr size_t kMinParallelBytes = 256 * 1024;
+constexpr size_t kMinChunkBytes = 64 * 1024;
+// Chunks per copy thread, leaves some room for load balancing.
+constexpr size_t kChunksPerThread = 4;
+constexpr size_t kMaxDefaultCopyThreads = 4;
+constexpr size_t kDefaultNTThreshold = 8 * 1024 * 1024;
+
+size_t round_up(size_t value, size_t align) {
+  return (value + align - 1) / align * align;
+}
+
+// Parse a sysfs cpulist such as "0-27,56-83".
+std::vector<int> parse_cpulist(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty())
+      continue;
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+// The CPUs of the NUMA node the calling thread currently runs on.
+// Returns an empty list when the topology is not available.
+std::vector<int> local_node_cpus() {
+  int current = sched_getcpu();
+  if (current < 0)
+    return {};
+
+  const std::string node_root = "/sys/devices/system/node/";
+  DIR* dir = opendir(node_root.c_str());
+  if (dir == nullptr)
+    return {};
+
+  std::vector<int> result;
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name(entry->d_name);
+    if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+        name.find_first_not_of("0123456789", 4) != std::string::npos)
+      continue;
+
+    std::ifstream file(node_root + name + "/cpulist");
+    std::string list;
+    if (!std::getline(file, list))
+      continue;
+
+    try {
+      auto cpus = parse_cpulist(list);
+      if (std::find(cpus.begin(), cpus.end(), current) != cpus.end()) {
+        result = std::move(cpus);
+        break;
+      }
+    } catch (const std::exception&) {
+      continue;
+    }
+  }
+  closedir(dir);
+  return result;
+}
+
+void copy_chunk(char* dst, const char* src, size_t bytes, bool non_temporal) {
+#if defined(__SSE2__)
+  if (non_temporal) {
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+    head = std::min(head, bytes);
+    std::memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    bytes -= head;
+
+    size_t body = bytes & ~static_cast<size_t>(63);
+    for (size_t off = 0; off < body; off += 64) {
+      __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + off));
+      __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + off + 16));
+      __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + off + 32));
+      __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + off + 48));
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dst + off), v0);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dst + off + 16), v1);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dst + off + 32), v2);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dst + off + 48), v3);
+    }
+    std::memcpy(dst + body, src + body, bytes - body);
+    // The streaming stores are weakly ordered, make them visible before
+    // the chunk is reported as done.
+    _mm_sfence();
+    return;
+  }
+#endif
+  std::memcpy(dst, src, bytes);
+}
+
+// A small fork-join pool dedicated to the staging copies. It is intentionally
+// separated from the intra-op pool so that packing a buffer for the
+// communication never competes with (or waits behind) the user's compute.
+class CopyPool {
+public:
+  static CopyPool& get() {
+    // Leaked on purpose: the pool may still be used by the CCL worker thread
+    // while the static objects are destroyed at exit.
+    static CopyPool* pool = new CopyPool();
+    return *pool;
+  }
+
+  // Number of threads taking part in a copy, the calling thread included.
+  size_t concurrency() const {
+    return workers_.size() + 1;
+  }
+
+  void parallel_for(size_t num_tasks, const std::function<void(size_t)>& fn) {
+    if (workers_.empty() || num_tasks <= 1) {
+      for (size_t i = 0; i < num_tasks; ++i) {
+        fn(i);
+      }
+      return;
+    }
+
+    std::lock_guard<std::mutex> dispatch(dispatchMutex_);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      fn_ = &fn;
+      numTasks_ = num_tasks;
+      nextTask_.store(0);
+      busyWorkers_ = workers_.size();
+      ++generation_;
+    }
+    startCV_.notify_all();
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCV_.wait(lock, [&] { return busyWorkers_ == 0; });
+    fn_ = nullptr;
+  }
+
+private:
+  CopyPool() {
+    size_t num_threads;
+    int env = oneccl_bindings_for_pytorch_copy_threads();
+    if (env > 0) {
+      num_threads = env;
+    } else {
+      size_t hw = std::thread::hardware_concurrency();
+      num_threads = std::max<size_t>(1, std::min(kMaxDefaultCopyThreads, hw / 2));
+    }
+
+    auto cpus = local_node_cpus();
+    for (size_t i = 1; i < num_threads; ++i) {
+      workers_.emplace_back(&CopyPool::workerLoop, this, cpus);
+    }
+  }
+
+  void workerLoop(std::vector<int> cpus) {
+    // Keep the copy threads on the NUMA node of the communication, the first
+    // touch of a new staging buffer then lands on the local memory.
+    if (!cpus.empty()) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (auto cpu : cpus) {
+        if (cpu < CPU_SETSIZE)
+          CPU_SET(cpu, &set);
+      }
+      sched_setaffinity(0, sizeof(set), &set);
+    }
+
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      startCV_.wait(lock, [&] { return generation_ != seen; });
+      seen = generation_;
+      lock.unlock();
+
+      drain();
+
+      lock.lock();
+      if (--busyWorkers_ == 0) {
+        doneCV_.notify_one();
+      }
+    }
+  }
+
+  void drain() {
+    size_t i;
+    while ((i = nextTask_.fetch_add(1)) < numTasks_) {
+      (*fn_)(i);
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  // Only one copy job is dispatched to the workers at a time.
+  std::mutex dispatchMutex_;
+  std::mutex mutex_;
+  std::condition_variable startCV_;
+  std::condition_variable doneCV_;
+  const std::function<void(size_t)>* fn_ = nullptr;
+  size_t numTasks_ = 0;
+  std::atomic<size_t> nextTask_{0};
+  size_t busyWorkers_ = 0;
+  uint64_t generation_ = 0;
+};
+
+size_t nt_threshold() {
+  static size_t threshold = [] {
+    int env = oneccl_bindings_for_pytorch_copy_nt_threshold();
+    if (env < 0)
+      return SIZE_MAX;
+    return env == 0 ? kDefaultNTThreshold : static_cast<size_t>(env);
+  }();
+  return threshold;
+}
+
+bool is_raw_copyable(const at::Tensor& dst, const at::Tensor& src) {
+  return dst.device().is_cpu() && src.device().is_cpu() &&
+         dst.scalar_type() == src.scalar_type() &&
+         dst.numel() == src.numel() &&
+         dst.is_contiguous() && src.is_contiguous() &&
+         !src.is_conj() && !src.is_neg();
+}
+
+} // namespace anonymous
+
+void staging_copy_raw(const std::vector<CopyTask>& tasks, bool to_staging) {
+  size_t total = 0;
+  for (const auto& task : tasks) {
+    total += task.bytes;
+  }
+  if (total == 0)
+    return;
+
+  bool non_temporal = to_staging && total >= nt_threshold();
+  auto& pool = CopyPool::get();
+  size_t concurrency = pool.concurrency();
+
+  if (concurrency == 1 || total < kMinParallelBytes) {
+    for (const auto& task : tasks) {
+      copy_chunk(static_cast<char*>(task.dst), static_cast<const char*>(task.src), task.bytes, non_temporal);
+    }
+    return;
+  }
+
+  // Split on the page boundaries of the destination, each page is then
+  // written (and first touched) by a single copy thread.
+  size_t chunk_size = std::max(kMinChunkBytes,
+                               round_up(total / (concurrency * kChunksPerThread), kPageSize));
+  std::vector<CopyTask> chunks;
+  chunks.reserve(total / chunk_size + 2 * tasks.size());
+  for (const auto& task : tasks) {
+    auto dst = static_cast<char*>(task.dst);
+    auto src = static_cast<const char*>(task.src);
+    uintptr_t base = reinterpret_cast<uintptr_t>(dst);
+    size_t offset = 0;
+    while (offset < task.bytes) {
+      size_t end = round_up(base + offset + chunk_size, kPageSize) - base;
+      end = std::min(end, task.bytes);
+      chunks.push_back({dst + offset, src + offset, end - offset});
+      offset = end;
+    }
+  }
+
+  pool.parallel_for(chunks.size(), [&](size_t i) {
+    const auto& chunk = chunks[i];
+    copy_chunk(static_cast<char*>(chunk.dst), static_cast<const char*>(chunk.src), chunk.bytes, non_temporal);
+  });
+}
+
+void staging_copy_(const at::Tensor& dst, const at::Tensor& src, bool to_staging) {
+  staging_copy_(std::vector<at::Tensor>{dst}, std::vector<at::Tensor>{src}, to_staging);
+}
+
+void staging_copy_(const std::vector<at::Tensor>& dsts, const std::vector<at::Tensor>& srcs,
+                   bool to_staging) {
+  TORCH_CHECK(dsts.size() == srcs.size(), "staging_copy_: number of destinations and sources doesn't match");
+
+  std::vector<CopyTask> tasks;
+  tasks.reserve(dsts.size());
+  for (size_t i = 0; i < dsts.size(); ++i) {
+    if (is_raw_copyable(dsts[i], srcs[i])) {
+      tasks.push_back({dsts[i].data_ptr(), srcs[i].data_ptr(), srcs[i].nbytes()});
+    } else {
+      dsts[i].copy_(srcs[i]);
+    }
+  }
+  staging_copy_raw(tasks, to_staging);
+}
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <ATen/ATen.h>
+
+namespace oneccl_bindings_for_pytorch {
+
+// Copy used to pack/unpack the staging buffers of the CPU collectives.
+// Large contiguous copies are split into page aligned chunks and executed on a
+// dedicated pool of copy threads (not the intra-op pool of the user), bound to
+// the NUMA node of the thread that first used the pool. Anything else falls
+// back to at::Tensor::copy_.
+// Only a staging destination, which is next read by oneCCL and not by the
+// user, may bypass the cache with streaming stores above the non-temporal
+// threshold. Unpacks into the user tensors always use regular stores.
+void staging_copy_(const at::Tensor& dst, const at::Tensor& src, bool to_staging = false);
+
+// Batched version of staging_copy_, all the pairs are copied in one dispatch
+// to the copy pool.
+void staging_copy_(const std::vector<at::Tensor>& dsts, const std::vector<at::Tensor>& srcs,
+                   bool to_staging = false);
+
+// Raw buffer variant, exposed for the callers which already hold the pointers.
+struct CopyTask {
+  void* dst;
+  const void* src;
+  size_t bytes;
+};
+
+void staging_copy_raw(const std::vector<CopyTask>& tasks, bool to_staging = false);
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "delta_broadcast.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <ATen/Parallel.h>
+#include <c10/util/irange.h>
+
+#include "cpu/quantization.h"
+
+namespace oneccl_bindings_for_pytorch {
+
+namespace {
+
+enum Mode : uint8_t {
+  // Every block, exactly.
+  kFull = 0,
+  // The changed blocks, exactly.
+  kChanged = 1,
+  // The block-quantized deltas of the changed blocks.
+  kQuantizedDelta = 2,
+};
+
+// Elements sharing a scale in the quantized deltas.
+constexpr int64_t kQuantBlock = 256;
+
+uint64_t hash_bytes(const void* data, int64_t bytes) {
+  constexpr uint64_t kMul = 0xff51afd7ed558ccdULL;
+  auto p = static_cast<const uint8_t*>(data);
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ (uint64_t) bytes;
+  int64_t i = 0;
+  for (; i + 8 <= bytes; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, p + i, 8);
+    h = (h ^ word) * kMul;
+    h ^= h >> 32;
+  }
+  uint64_t tail = 0;
+  std::memcpy(&tail, p + i, bytes - i);
+  h = (h ^ tail) * kMul;
+  return h ^ (h >> 33);
+}
+
+} // namespace
+
+DeltaBroadcaster::DeltaBroadcaster(c10::intrusive_ptr<c10d::ProcessGroupCCL> pg,
+                                   std::vector<at::Tensor> tensors,
+                                   int root,
+                                   int64_t blockSize,
+                                   int quantBits,
+                                   int64_t refreshEvery)
+        : pg_(std::move(pg)), tensors_(std::move(tensors)), root_(root), quantBits_(quantBits),
+          refreshEvery_(refreshEvery) {
+  TORCH_CHECK(root >= 0 && root < pg_->getSize(), "invalid root ", root);
+  TORCH_CHECK(blockSize > 0, "the block size must be positive, got ", blockSize);
+  TORCH_CHECK(quantBits == 0 || quantBits == 4 || quantBits == 8,
+              "the deltas are quantized to 8 or 4 bits (0 to send them exactly), got ", quantBits);
+  TORCH_CHECK(refreshEvery >= 0, "refresh_every must not be negative, got ", refreshEvery);
+  for (const auto i : c10::irange(tensors_.size())) {
+    const auto& tensor = tensors_[i];
+    TORCH_CHECK(tensor.device().is_cpu() && tensor.is_contiguous(),
+                "delta broadcasts update contiguous CPU tensors in place");
+    TORCH_CHECK(quantBits == 0 || at::isFloatingType(tensor.scalar_type()),
+                "quantized deltas need floating point tensors, got ", tensor.scalar_type());
+    for (int64_t offset = 0; offset < tensor.numel(); offset += blockSize) {
+      blocks_.push_back({(int64_t) i, offset, std::min(blockSize, tensor.numel() - offset)});
+    }
+    totalBytes_ += tensor.nbytes();
+  }
+
+  // The ranks must agree on the blocks, or the headers and payloads would be
+  // read with the wrong offsets.
+  std::vector<int64_t> layout{(int64_t) tensors_.size(), blockSize, quantBits};
+  for (const auto& tensor : tensors_) {
+    layout.push_back((int64_t) tensor.scalar_type());
+    layout.push_back(tensor.dim());
+    for (const auto size : tensor.sizes()) {
+      layout.push_back(size);
+    }
+  }
+  const auto checksum = (int64_t) hash_bytes(layout.data(), layout.size() * sizeof(int64_t));
+  auto rootChecksum = at::full({1}, checksum, at::kLong);
+  broadcastTensor(rootChecksum);
+  TORCH_CHECK(rootChecksum.item<int64_t>() == checksum,
+              "the tensors, block size or quant_bits of rank ", pg_->getRank(),
+              " do not match those of the root ", root_);
+}
+
+int64_t DeltaBroadcaster::payloadBytes(const Block& block, bool quantized) const {
+  return quantized ? quantized_nbytes(block.numel, quantBits_, kQuantBlock)
+                   : block.numel * tensors_[block.tensor].element_size();
+}
+
+void DeltaBroadcaster::broadcastTensor(at::Tensor& tensor) {
+  std::vector<at::Tensor> tensors{tensor};
+  c10d::BroadcastOptions opts;
+  opts.rootRank = root_;
+  pg_->broadcast(tensors, opts)->wait();
+}
+
+void DeltaBroadcaster::broadcast() {
+  const bool isRoot = pg_->getRank() == root_;
+  const int64_t count = blocks_.size();
+
+  // The mode, then a flag per block.
+  auto header = at::zeros({1 + count}, at::kByte);
+  auto flags = header.data_ptr<uint8_t>();
+  if (isRoot) {
+    const bool refresh = reference_.empty() ||
+                         (quantBits_ != 0 && refreshEvery_ > 0 && sinceRefresh_ >= refreshEvery_);
+    flags[0] = refresh ? kFull : quantBits_ != 0 ? kQuantizedDelta : kChanged;
+    if (reference_.empty()) {
+      for (const auto& tensor : tensors_) {
+        reference_.push_back(at::empty_like(tensor));
+      }
+      if (quantBits_ != 0) {
+        hashes_.resize(count);
+      }
+    }
+    // A block changed if the tensors of the root did since the last broadcast.
+    at::parallel_for(0, count, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t b = begin; b < end; ++b) {
+        const auto& block = blocks_[b];
+        const int64_t elementSize = tensors_[block.tensor].element_size();
+        const int64_t blockBytes = block.numel * elementSize;
+        auto current = static_cast<const uint8_t*>(tensors_[block.tensor].data_ptr()) + block.offset * elementSize;
+        if (quantBits_ != 0) {
+          const auto hash = hash_bytes(current, blockBytes);
+          flags[1 + b] = refresh || hash != hashes_[b];
+          hashes_[b] = hash;
+        } else {
+          auto previous = static_cast<const uint8_t*>(reference_[block.tensor].data_ptr()) + block.offset * elementSize;
+          flags[1 + b] = refresh || std::memcmp(current, previous, blockBytes) != 0;
+        }
+      }
+    });
+  }
+  broadcastTensor(header);
+
+  const auto mode = flags[0];
+  const bool quantized = mode == kQuantizedDelta;
+  std::vector<int64_t> changed;
+  std::vector<int64_t> offsets;
+  int64_t bytes = 0;
+  for (const auto b : c10::irange(count)) {
+    if (flags[1 + b]) {
+      changed.push_back(b);
+      offsets.push_back(bytes);
+      bytes += payloadBytes(blocks_[b], quantized);
+    }
+  }
+
+  auto payload = at::empty({bytes}, at::kByte);
+  auto data = payload.data_ptr<uint8_t>();
+  auto blockOf = [&](const std::vector<at::Tensor>& tensors, int64_t b) {
+    const auto& block = blocks_[b];
+    return tensors[block.tensor].view(-1).narrow(0, block.offset, block.numel);
+  };
+  // Both sides apply the same dequantized delta, the root to its copy.
+  auto applyDelta = [&](const at::Tensor& target, int64_t b, int64_t offset) {
+    auto delta = at::empty({blocks_[b].numel}, at::kFloat);
+    dequantize_blockwise(payload.narrow(0, offset, payloadBytes(blocks_[b], true)), delta, quantBits_, kQuantBlock);
+    target.add_(delta);
+  };
+
+  if (isRoot && bytes > 0) {
+    at::parallel_for(0, changed.size(), 1, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        const int64_t b = changed[i];
+        auto current = blockOf(tensors_, b);
+        auto reference = blockOf(reference_, b);
+        if (quantized) {
+          auto delta = (current.to(at::kFloat) - reference.to(at::kFloat)).contiguous();
+          quantize_blockwise(delta, payload.narrow(0, offsets[i], payloadBytes(blocks_[b], true)),
+                             quantBits_, kQuantBlock);
+          applyDelta(reference, b, offsets[i]);
+        } else {
+          std::memcpy(data + offsets[i], current.data_ptr(), current.nbytes());
+          reference.copy_(current);
+        }
+      }
+    });
+  }
+  if (bytes > 0) {
+    broadcastTensor(payload);
+  }
+  if (!isRoot && bytes > 0) {
+    at::parallel_for(0, changed.size(), 1, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        const int64_t b = changed[i];
+        auto target = blockOf(tensors_, b);
+        if (quantized) {
+          applyDelta(target, b, offsets[i]);
+        } else {
+          std::memcpy(target.data_ptr(), data + offsets[i], target.nbytes());
+        }
+      }
+    });
+  }
+
+  sinceRefresh_ = mode == kFull ? 0 : sinceRefresh_ + 1;
+  stats_.broadcasts++;
+  stats_.fullRefreshes += mode == kFull;
+  stats_.blocksSent += changed.size();
+  stats_.bytesSent += header.nbytes() + bytes;
+  stats_.fullBytes += totalBytes_;
+}
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "ProcessGroupCCL.hpp"
+
+namespace oneccl_bindings_for_pytorch {
+
+// Repeated broadcast of the same set of tensors, e.g. the weights a learner
+// sends to its actors, which only sends the blocks changed since the last
+// broadcast. Each broadcast sends a header with a flag per block of
+// `blockSize` elements, then the changed blocks packed together.
+//
+// The root keeps a copy of what the other ranks hold to find the changed
+// blocks. The other ranks update their tensors in place, and must not modify
+// them between two broadcasts. With quantBits (8 or 4) the changed blocks of
+// floating point tensors are sent as block-quantized deltas from that copy,
+// so the quantization error of a block is sent with its next change, and the
+// root finds the changed blocks by a hash of each block instead. Every
+// refreshEvery broadcasts (if not 0) all the blocks are sent exactly.
+//
+// The constructor is collective: it checks that the tensors of every rank
+// have the layout of those of the root.
+class DeltaBroadcaster {
+public:
+  struct Stats {
+    uint64_t broadcasts = 0;
+    uint64_t fullRefreshes = 0;
+    uint64_t blocksSent = 0;
+    // Bytes of the headers and payloads, and of the same plain broadcasts.
+    uint64_t bytesSent = 0;
+    uint64_t fullBytes = 0;
+  };
+
+  DeltaBroadcaster(c10::intrusive_ptr<c10d::ProcessGroupCCL> pg,
+                   std::vector<at::Tensor> tensors,
+                   int root,
+                   int64_t blockSize,
+                   int quantBits,
+                   int64_t refreshEvery);
+
+  // Collective: brings the tensors of every rank to those of the root.
+  void broadcast();
+
+  Stats stats() const {
+    return stats_;
+  }
+
+private:
+  struct Block {
+    int64_t tensor;
+    int64_t offset;
+    int64_t numel;
+  };
+
+  int64_t payloadBytes(const Block& block, bool quantized) const;
+
+  void broadcastTensor(at::Tensor& tensor);
+
+  c10::intrusive_ptr<c10d::ProcessGroupCCL> pg_;
+  std::vector<at::Tensor> tensors_;
+  // What the other ranks hold, on the root only.
+  std::vector<at::Tensor> reference_;
+  // The hash of each block of the root at the last broadcast, when
+  // reference_ differs from it because of the quantized deltas.
+  std::vector<uint64_t> hashes_;
+  std::vector<Block> blocks_;
+  const int root_;
+  const int quantBits_;
+  const int64_t refreshEvery_;
+  int64_t sinceRefresh_ = 0;
+  int64_t totalBytes_ = 0;
+  Stats stats_;
+};
+
+} // namespace oneccl_bindings_for_pytorch
@@ -29,9 +29,12 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <dlfcn.h>
+#include <algorithm>
 #include <chrono>
 #include "env.h"
 #include "dispatch_stub.h"
+#include "phase_timer.h"
 
 
 namespace oneccl_bindings_for_pytorch {
@@ -42,6 +45,60 @@ static DispatchStub default_stubs;
 constexpr DispatchStub* default_stubs_addr = &default_stubs;
 constexpr auto num_dev_type = static_cast<std::underlying_type<c10::DeviceType>::type>(c10::DeviceType::COMPILE_TIME_MAX_DEVICE_TYPES);
 
+// Complex tensors are communicated as pairs of real numbers, through a view.
+static bool any_complex(const std::vector<at::Tensor>& tensors) {
+  return std::any_of(tensors.begin(), tensors.end(), [](const at::Tensor& t) { return t.is_complex(); });
+}
+
+static bool any_complex(const std::vector<std::vector<at::Tensor>>& tensors) {
+  return std::any_of(tensors.begin(), tensors.end(), [](const std::vector<at::Tensor>& t) { return any_complex(t); });
+}
+
+static at::Tensor view_as_real_if_complex(const at::Tensor& tensor) {
+  return tensor.is_complex() ? at::view_as_real(tensor) : tensor;
+}
+
+static std::vector<at::Tensor> view_as_real_if_complex(const std::vector<at::Tensor>& tensors) {
+  std::vector<at::Tensor> real;
+  for (const auto& tensor : tensors) {
+    real.push_back(view_as_real_if_complex(tensor));
+  }
+  return real;
+}
+
+static std::vector<std::vector<at::Tensor>> view_as_real_if_complex(const std::vector<std::vector<at::Tensor>>& tensors) {
+  std::vector<std::vector<at::Tensor>> real;
+  for (const auto& list : tensors) {
+    real.push_back(view_as_real_if_complex(list));
+  }
+  return real;
+}
+
+static std::vector<at::Tensor> flatten_lists(const std::vector<std::vector<at::Tensor>>& tensors) {
+  std::vector<at::Tensor> flat;
+  for (const auto& list : tensors) {
+    flat.insert(flat.end(), list.begin(), list.end());
+  }
+  return flat;
+}
+
+// The work of the real views returns the complex tensors of the caller.
+static c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> with_complex_result(
+        c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work,
+        const std::vector<at::Tensor>& real,
+        const std::vector<at::Tensor>& complex) {
+  if (work) {
+    work->setResultTensors(real, complex);
+  }
+  return work;
+}
+
+// Only the ops which apply to the real and imaginary parts independently.
+static void check_complex_reduce_op(const ReduceOp& op) {
+  TORCH_CHECK(op == ReduceOp::SUM || op == ReduceOp::AVG,
+              "only ReduceOp.SUM and ReduceOp.AVG are supported for complex tensors");
+}
+
 static void format_tensors_size(std::ostream& os, const at::Tensor& tensor) {
   os << "(" << tensor.device() << ", " << tensor.sizes() << ")";
 }
@@ -542,16 +599,45 @@ void DispatchStub::register_ccl_stub(c10::DeviceType dev_type, DispatchStub* stu
   dispatch_stubs[stub_idx] = stub;
 }
 
+// The XPU stubs live in their own library, which pulls in the SYCL and Level
+// Zero runtimes. It is loaded from next to this library by the first XPU
+// collective, so that CPU-only processes never pay for it.
+static bool load_xpu_stubs() {
+  static bool loaded = []() {
+    Dl_info info;
+    if (!dladdr(reinterpret_cast<void*>(&load_xpu_stubs), &info) || !info.dli_fname) {
+      return false;
+    }
+    std::string path(info.dli_fname);
+    path = path.substr(0, path.rfind('/') + 1) + "liboneccl_bindings_for_pytorch_xpu.so";
+    if (!dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL)) {
+      TORCH_WARN("Cannot load xpu CCL. CCL doesn't work for XPU device due to ", dlerror());
+      return false;
+    }
+    return true;
+  }();
+  return loaded;
+}
+
 DispatchStub* DispatchStub::get_ccl_stub(c10::DeviceType dev_type) {
   auto stub_idx = to_int(dev_type);
   auto dispatch_stubs = get_dispatch_stub();
   TORCH_CHECK(stub_idx < dispatch_stubs.size(), "unknown device type [", dev_type, "].");
+  if (dev_type == c10::DeviceType::XPU && dispatch_stubs[stub_idx] == default_stubs_addr && load_xpu_stubs()) {
+    return get_dispatch_stub()[stub_idx];
+  }
   return dispatch_stubs[stub_idx];
 }
 
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::allreduce(std::vector<at::Tensor>& tensors,
                                                                        const AllreduceOptions& opts,
                                                                        ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(tensors)) {
+    check_complex_reduce_op(opts.reduceOp);
+    auto real = view_as_real_if_complex(tensors);
+    return with_complex_result(allreduce(real, opts, pg_ccl), real, tensors);
+  }
   checkSameType(tensors[0], tensors);
   c10::DeviceType dev_type = tensors[0].device().type();
   check_supported_reduce_op(dev_type, opts.reduceOp);
@@ -561,6 +647,12 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::allreduce(std::v
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::allreduce_coalesced(std::vector<at::Tensor>& tensors,
                                                                        const AllreduceOptions& opts,
                                                                        ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(tensors)) {
+    check_complex_reduce_op(opts.reduceOp);
+    auto real = view_as_real_if_complex(tensors);
+    return with_complex_result(allreduce_coalesced(real, opts, pg_ccl), real, tensors);
+  }
   checkSameType(tensors[0], tensors);
   c10::DeviceType dev_type = tensors[0].device().type();
   check_supported_reduce_op(dev_type, opts.reduceOp);
@@ -570,6 +662,12 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::allreduce_coales
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::reduce(std::vector<at::Tensor>& tensors,
                                                              const ReduceOptions& opts,
                                                              ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(tensors)) {
+    check_complex_reduce_op(opts.reduceOp);
+    auto real = view_as_real_if_complex(tensors);
+    return with_complex_result(reduce(real, opts, pg_ccl), real, tensors);
+  }
   checkSameType(tensors[0], tensors);
   c10::DeviceType dev_type = tensors[0].device().type();
   check_supported_reduce_op(dev_type, opts.reduceOp);
@@ -580,15 +678,79 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::reduce(std::vect
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::broadcast(std::vector<at::Tensor>& tensors,
                                                                 const BroadcastOptions& opts,
                                                                 ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(tensors)) {
+    auto real = view_as_real_if_complex(tensors);
+    return with_complex_result(broadcast(real, opts, pg_ccl), real, tensors);
+  }
   checkSameType(tensors[0], tensors);
   c10::DeviceType dev_type = tensors[0].device().type();
   return get_ccl_stub(dev_type)->broadcast_(tensors, opts, pg_ccl);
 }
 
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::allreduce_oop(std::vector<at::Tensor>& outputTensors,
+                                                                    std::vector<at::Tensor>& inputTensors,
+                                                                    const AllreduceOptions& opts,
+                                                                    ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  checkOutOfPlace(outputTensors, inputTensors);
+  if (any_complex(inputTensors)) {
+    check_complex_reduce_op(opts.reduceOp);
+    auto realOutputs = view_as_real_if_complex(outputTensors);
+    auto realInputs = view_as_real_if_complex(inputTensors);
+    return with_complex_result(allreduce_oop(realOutputs, realInputs, opts, pg_ccl), realOutputs, outputTensors);
+  }
+  checkSameType(inputTensors[0], inputTensors);
+  c10::DeviceType dev_type = inputTensors[0].device().type();
+  check_supported_reduce_op(dev_type, opts.reduceOp);
+  return get_ccl_stub(dev_type)->allreduce_oop_(outputTensors, inputTensors, opts, pg_ccl);
+}
+
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::reduce_oop(std::vector<at::Tensor>& outputTensors,
+                                                                 std::vector<at::Tensor>& inputTensors,
+                                                                 const ReduceOptions& opts,
+                                                                 ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  checkOutOfPlace(outputTensors, inputTensors);
+  if (any_complex(inputTensors)) {
+    check_complex_reduce_op(opts.reduceOp);
+    auto realOutputs = view_as_real_if_complex(outputTensors);
+    auto realInputs = view_as_real_if_complex(inputTensors);
+    return with_complex_result(reduce_oop(realOutputs, realInputs, opts, pg_ccl), realOutputs, outputTensors);
+  }
+  checkSameType(inputTensors[0], inputTensors);
+  c10::DeviceType dev_type = inputTensors[0].device().type();
+  check_supported_reduce_op(dev_type, opts.reduceOp);
+  return get_ccl_stub(dev_type)->reduce_oop_(outputTensors, inputTensors, opts, pg_ccl);
+}
+
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::broadcast_oop(std::vector<at::Tensor>& outputTensors,
+                                                                    std::vector<at::Tensor>& inputTensors,
+                                                                    const BroadcastOptions& opts,
+                                                                    ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  checkOutOfPlace(outputTensors, inputTensors);
+  if (any_complex(inputTensors)) {
+    auto realOutputs = view_as_real_if_complex(outputTensors);
+    auto realInputs = view_as_real_if_complex(inputTensors);
+    return with_complex_result(broadcast_oop(realOutputs, realInputs, opts, pg_ccl), realOutputs, outputTensors);
+  }
+  checkSameType(inputTensors[0], inputTensors);
+  c10::DeviceType dev_type = inputTensors[0].device().type();
+  return get_ccl_stub(dev_type)->broadcast_oop_(outputTensors, inputTensors, opts, pg_ccl);
+}
+
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::allgather(std::vector<std::vector<at::Tensor>>& outputTensors,
                                                                 std::vector<at::Tensor>& inputTensors,
                                                                 const AllgatherOptions& opts,
                                                                 ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(inputTensors) || any_complex(outputTensors)) {
+    auto realOutputs = view_as_real_if_complex(outputTensors);
+    auto realInputs = view_as_real_if_complex(inputTensors);
+    return with_complex_result(allgather(realOutputs, realInputs, opts, pg_ccl),
+                               flatten_lists(realOutputs), flatten_lists(outputTensors));
+  }
   checkSameType(inputTensors[0], inputTensors);
   checkSameType(inputTensors[0], outputTensors);
   c10::DeviceType dev_type = inputTensors[0].device().type();
@@ -600,7 +762,13 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::_allgather_base(
                                                                 at::Tensor& inputTensor,
                                                                 const AllgatherOptions& opts,
                                                                 ProcessGroupCCL& pg_ccl) {
-  checkSameType(inputTensor, std::vector{outputTensor});
+  ScopedPhase phase(Phase::DISPATCH);
+  if (inputTensor.is_complex() || outputTensor.is_complex()) {
+    auto realOutput = view_as_real_if_complex(outputTensor);
+    auto realInput = view_as_real_if_complex(inputTensor);
+    return with_complex_result(_allgather_base(realOutput, realInput, opts, pg_ccl), {realOutput}, {outputTensor});
+  }
+  checkSameTypeOrCastable(inputTensor, std::vector{outputTensor});
   c10::DeviceType dev_type = inputTensor.device().type();
   return get_ccl_stub(dev_type)->_allgather_base_(outputTensor, inputTensor, opts, pg_ccl);
 }
@@ -610,6 +778,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::allgather_into_t
                                                             std::vector<at::Tensor>& inputTensors,
                                                             const AllgatherOptions& opts,
                                                             ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
   checkSameType(inputTensors[0], inputTensors);
   checkSameType(outputTensors[0], outputTensors);
   c10::DeviceType dev_type = inputTensors[0].device().type();
@@ -620,6 +789,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::gather(std::vect
                                                              std::vector<at::Tensor>& inputTensors,
                                                              const GatherOptions& opts,
                                                              ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
   checkSameType(inputTensors[0], inputTensors);
   checkSameType(inputTensors[0], outputTensors);
   c10::DeviceType dev_type = inputTensors[0].device().type();
@@ -630,6 +800,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::scatter(std::vec
                                                               std::vector<std::vector<at::Tensor>>& inputTensors,
                                                               const ScatterOptions& opts,
                                                               ProcessGroupCCL& pg_ccl){
+  ScopedPhase phase(Phase::DISPATCH);
   checkSameType(outputTensors[0], inputTensors);
   checkSameType(outputTensors[0], outputTensors);
   c10::DeviceType dev_type = outputTensors[0].device().type();
@@ -640,6 +811,13 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::reduce_scatter(s
                                                                 std::vector<std::vector<at::Tensor>>& inputTensors,
                                                                 const ReduceScatterOptions& opts,
                                                                 ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(inputTensors) || any_complex(outputTensors)) {
+    check_complex_reduce_op(opts.reduceOp);
+    auto realOutputs = view_as_real_if_complex(outputTensors);
+    auto realInputs = view_as_real_if_complex(inputTensors);
+    return with_complex_result(reduce_scatter(realOutputs, realInputs, opts, pg_ccl), realOutputs, outputTensors);
+  }
   c10::DeviceType dev_type = outputTensors[0].device().type();
   check_supported_reduce_op(dev_type, opts.reduceOp);
   return get_ccl_stub(dev_type)->reduce_scatter_(outputTensors, inputTensors, opts, pg_ccl);
@@ -649,6 +827,14 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::_reduce_scatter_
                                                                 at::Tensor& inputTensor,
                                                                 const ReduceScatterOptions& opts,
                                                                 ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (inputTensor.is_complex() || outputTensor.is_complex()) {
+    check_complex_reduce_op(opts.reduceOp);
+    auto realOutput = view_as_real_if_complex(outputTensor);
+    auto realInput = view_as_real_if_complex(inputTensor);
+    return with_complex_result(_reduce_scatter_base(realOutput, realInput, opts, pg_ccl), {realOutput}, {outputTensor});
+  }
+  checkSameTypeOrCastable(inputTensor, std::vector{outputTensor});
   c10::DeviceType dev_type = inputTensor.device().type();
   check_supported_reduce_op(dev_type, opts.reduceOp);
   return get_ccl_stub(dev_type)->_reduce_scatter_base_(outputTensor, inputTensor, opts, pg_ccl);
@@ -659,6 +845,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::reduce_scatter_t
                                                             std::vector<at::Tensor>& inputTensors,
                                                             const ReduceScatterOptions& opts,
                                                             ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
   checkSameType(inputTensors[0], inputTensors);
   checkSameType(outputTensors[0], outputTensors);
   c10::DeviceType dev_type = inputTensors[0].device().type();
@@ -672,6 +859,13 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::alltoall_base(at
                                                                     std::vector<int64_t>& inputSplitSizes,
                                                                     const AllToAllOptions& opts,
                                                                     ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (inputTensor.is_complex() || outputTensor.is_complex()) {
+    auto realOutput = view_as_real_if_complex(outputTensor);
+    auto realInput = view_as_real_if_complex(inputTensor);
+    return with_complex_result(alltoall_base(realOutput, realInput, outputSplitSizes, inputSplitSizes, opts, pg_ccl),
+                               {realOutput}, {outputTensor});
+  }
   checkSameType(inputTensor, {outputTensor});
   c10::DeviceType dev_type = inputTensor.device().type();
   return get_ccl_stub(dev_type)->alltoall_base_(outputTensor, inputTensor, outputSplitSizes, inputSplitSizes, opts, pg_ccl);
@@ -681,6 +875,12 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::alltoall(std::ve
                                                                std::vector<at::Tensor>& inputTensors,
                                                                const AllToAllOptions& opts,
                                                                ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(inputTensors) || any_complex(outputTensors)) {
+    auto realOutputs = view_as_real_if_complex(outputTensors);
+    auto realInputs = view_as_real_if_complex(inputTensors);
+    return with_complex_result(alltoall(realOutputs, realInputs, opts, pg_ccl), realOutputs, outputTensors);
+  }
   checkSameType(inputTensors[0], inputTensors);
   checkSameType(inputTensors[0], outputTensors);
   c10::DeviceType dev_type = inputTensors[0].device().type();
@@ -691,6 +891,11 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::send(std::vector
                                                                        int dstRank,
                                                                        int tag,
                                                                        ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(tensors)) {
+    auto real = view_as_real_if_complex(tensors);
+    return with_complex_result(send(real, dstRank, tag, pg_ccl), real, tensors);
+  }
   checkSameType(tensors[0], tensors);
   c10::DeviceType dev_type = tensors[0].device().type();
   return get_ccl_stub(dev_type)->send_(tensors, dstRank, tag, pg_ccl);
@@ -700,14 +905,69 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::recv(std::vector
                                                                        int srcRank,
                                                                        int tag,
                                                                        ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(tensors)) {
+    auto real = view_as_real_if_complex(tensors);
+    return with_complex_result(recv(real, srcRank, tag, pg_ccl), real, tensors);
+  }
   checkSameType(tensors[0], tensors);
   c10::DeviceType dev_type = tensors[0].device().type();
   return get_ccl_stub(dev_type)->recv_(tensors, srcRank, tag, pg_ccl);
 }
 
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::prepost_recv(std::vector<at::Tensor>& tensors,
+                                                                   int srcRank,
+                                                                   ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  if (any_complex(tensors)) {
+    auto real = view_as_real_if_complex(tensors);
+    return with_complex_result(prepost_recv(real, srcRank, pg_ccl), real, tensors);
+  }
+  checkSameType(tensors[0], tensors);
+  c10::DeviceType dev_type = tensors[0].device().type();
+  return get_ccl_stub(dev_type)->prepost_recv_(tensors, srcRank, pg_ccl);
+}
+
+c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::ring_exchange(std::vector<at::Tensor>& sendToNext,
+                                                                    std::vector<at::Tensor>& recvFromPrev,
+                                                                    std::vector<at::Tensor>& sendToPrev,
+                                                                    std::vector<at::Tensor>& recvFromNext,
+                                                                    ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
+  TORCH_CHECK(!sendToNext.empty() || !sendToPrev.empty(), "ring_exchange needs at least one tensor to send");
+  TORCH_CHECK(pg_ccl.getSize() > 1, "ring_exchange needs at least 2 ranks");
+  if (!sendToNext.empty()) {
+    checkOutOfPlace(recvFromPrev, sendToNext);
+  }
+  if (!sendToPrev.empty()) {
+    checkOutOfPlace(recvFromNext, sendToPrev);
+  }
+  if (any_complex(sendToNext) || any_complex(sendToPrev)) {
+    auto realSendToNext = view_as_real_if_complex(sendToNext);
+    auto realRecvFromPrev = view_as_real_if_complex(recvFromPrev);
+    auto realSendToPrev = view_as_real_if_complex(sendToPrev);
+    auto realRecvFromNext = view_as_real_if_complex(recvFromNext);
+    auto work = ring_exchange(realSendToNext, realRecvFromPrev, realSendToPrev, realRecvFromNext, pg_ccl);
+    realRecvFromPrev.insert(realRecvFromPrev.end(), realRecvFromNext.begin(), realRecvFromNext.end());
+    std::vector<at::Tensor> received(recvFromPrev);
+    received.insert(received.end(), recvFromNext.begin(), recvFromNext.end());
+    return with_complex_result(work, realRecvFromPrev, received);
+  }
+  auto& first = sendToNext.empty() ? sendToPrev[0] : sendToNext[0];
+  TORCH_CHECK(std::all_of(sendToPrev.begin(), sendToPrev.end(),
+                          [&](const at::Tensor& t) { return t.device().type() == first.device().type(); }),
+              "ring_exchange tensors are not on the same device type");
+  c10::DeviceType dev_type = first.device().type();
+  return get_ccl_stub(dev_type)->ring_exchange_(sendToNext, recvFromPrev, sendToPrev, recvFromNext, pg_ccl);
+}
+
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::barrier(const BarrierOptions& opts,
                                                               ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
 #ifdef USE_GPU
+  // The device of a barrier must not depend on what the process has loaded so
+  // far, all the ranks have to run the same barrier. It loads the XPU support
+  // if no XPU collective did yet.
   c10::DeviceType dev_type = c10::DeviceType::XPU;
 #else
   c10::DeviceType dev_type = c10::DeviceType::CPU;
@@ -716,6 +976,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::barrier(const Ba
 }
 
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> DispatchStub::end_coalescing(ProcessGroupCCL& pg_ccl) {
+  ScopedPhase phase(Phase::DISPATCH);
     return get_ccl_stub(c10::DeviceType::XPU)->end_coalescing_(pg_ccl);
 }
 
@@ -63,6 +63,21 @@ public:
                                                                   const BroadcastOptions& opts,
                                                                   ProcessGroupCCL& pg_ccl);
 
+  static c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> allreduce_oop(std::vector<at::Tensor>& outputTensors,
+                                                                      std::vector<at::Tensor>& inputTensors,
+                                                                      const AllreduceOptions& opts,
+                                                                      ProcessGroupCCL& pg_ccl);
+
+  static c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> reduce_oop(std::vector<at::Tensor>& outputTensors,
+                                                                   std::vector<at::Tensor>& inputTensors,
+                                                                   const ReduceOptions& opts,
+                                                                   ProcessGroupCCL& pg_ccl);
+
+  static c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> broadcast_oop(std::vector<at::Tensor>& outputTensors,
+                                                                      std::vector<at::Tensor>& inputTensors,
+                                                                      const BroadcastOptions& opts,
+                                                                      ProcessGroupCCL& pg_ccl);
+
   static c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> allgather(std::vector<std::vector<at::Tensor>>& outputTensors,
                                                                   std::vector<at::Tensor>& inputTensors,
                                                                   const AllgatherOptions& opts,
@@ -127,6 +142,16 @@ public:
                                                                 int tag,
                                                                 ProcessGroupCCL& pg_ccl);  
 
+  static c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> prepost_recv(std::vector<at::Tensor>& tensors,
+                                                                     int srcRank,
+                                                                     ProcessGroupCCL& pg_ccl);
+
+  static c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> ring_exchange(std::vector<at::Tensor>& sendToNext,
+                                                                      std::vector<at::Tensor>& recvFromPrev,
+                                                                      std::vector<at::Tensor>& sendToPrev,
+                                                                      std::vector<at::Tensor>& recvFromNext,
+                                                                      ProcessGroupCCL& pg_ccl);
+
   static c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> barrier(const BarrierOptions& opts,
                                                                 ProcessGroupCCL& pg_ccl);
 
@@ -263,6 +288,54 @@ public:
     return c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>();
   }
 
+  // The out-of-place variants leave the inputs untouched and write the results
+  // into the outputs. By default, the inputs are copied into the outputs, which
+  // are then reduced or broadcast in place, except that the ranks other than
+  // the root of a reduce reduce from a copy of their inputs, as their outputs
+  // are not written. The backends which read from a distinct send buffer
+  // override them.
+  virtual c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> allreduce_oop_(std::vector<at::Tensor>& outputTensors,
+                                                                        std::vector<at::Tensor>& inputTensors,
+                                                                        const AllreduceOptions& opts,
+                                                                        ProcessGroupCCL& pg_ccl) {
+    for (size_t i = 0; i < inputTensors.size(); ++i) {
+      outputTensors[i].copy_(inputTensors[i]);
+    }
+    if (outputTensors.size() == 1) {
+      return allreduce_(outputTensors, opts, pg_ccl);
+    }
+    return allreduce_coalesced_(outputTensors, opts, pg_ccl);
+  }
+
+  virtual c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> reduce_oop_(std::vector<at::Tensor>& outputTensors,
+                                                                     std::vector<at::Tensor>& inputTensors,
+                                                                     const ReduceOptions& opts,
+                                                                     ProcessGroupCCL& pg_ccl) {
+    if (pg_ccl.getRank() != opts.rootRank) {
+      std::vector<at::Tensor> copies;
+      for (const auto& input : inputTensors) {
+        copies.push_back(input.clone());
+      }
+      return reduce_(copies, opts, pg_ccl);
+    }
+    for (size_t i = 0; i < inputTensors.size(); ++i) {
+      outputTensors[i].copy_(inputTensors[i]);
+    }
+    return reduce_(outputTensors, opts, pg_ccl);
+  }
+
+  virtual c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> broadcast_oop_(std::vector<at::Tensor>& outputTensors,
+                                                                        std::vector<at::Tensor>& inputTensors,
+                                                                        const BroadcastOptions& opts,
+                                                                        ProcessGroupCCL& pg_ccl) {
+    if (pg_ccl.getRank() == opts.rootRank) {
+      for (size_t i = 0; i < inputTensors.size(); ++i) {
+        outputTensors[i].copy_(inputTensors[i]);
+      }
+    }
+    return broadcast_(outputTensors, opts, pg_ccl);
+  }
+
   virtual c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> send_(std::vector<at::Tensor>& tensors,
                                                                 int dstRank,
                                                                 int tag,
@@ -279,6 +352,26 @@ public:
     return c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>();                                                            
   }
 
+  // Posts a receive ahead of its use and returns its work without handing it
+  // to the progress thread, so that a receive waiting for its sender never
+  // delays the completion of the ops issued after it. The caller completes the
+  // work with synchronize() and finishAsyncWorkCCL().
+  virtual c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> prepost_recv_(std::vector<at::Tensor>& tensors,
+                                                                       int srcRank,
+                                                                       ProcessGroupCCL& pg_ccl) {
+    fail(tensors[0].device().type(), "prepost_recv");
+    return c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>();
+  }
+
+  virtual c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> ring_exchange_(std::vector<at::Tensor>& sendToNext,
+                                                                        std::vector<at::Tensor>& recvFromPrev,
+                                                                        std::vector<at::Tensor>& sendToPrev,
+                                                                        std::vector<at::Tensor>& recvFromNext,
+                                                                        ProcessGroupCCL& pg_ccl) {
+    fail(sendToNext.empty() ? sendToPrev[0].device().type() : sendToNext[0].device().type(), "ring_exchange");
+    return c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>();
+  }
+
   virtual c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> end_coalescing_(ProcessGroupCCL& pg_ccl) {
     TORCH_CHECK(false, "oneccl_bindings_for_pytorch: end_coalescing isn't implementd on backend [", c10::DeviceType::CPU, "].");
     return c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL>();
@@ -6,6 +6,9 @@
  * All available launch options for ONECCL_BINDINGS_FOR_PYTORCH
  * ONECCL_BINDINGS_FOR_PYTORCH_ENV_VERBOSE:           Default = 0, Set verbose level in ONECCL_BINDINGS_FOR_PYTORCH
  * ONECCL_BINDINGS_FOR_PYTORCH_ENV_WAIT_GDB:          Default = 0, Set 1 to force the oneccl_bindings_for_pytorch wait for GDB attaching
+ * ONECCL_BINDINGS_FOR_PYTORCH_ENV_COPY_THREADS:      Default = 0, Threads used for the CPU staging copies (0: auto, 1: copy on the calling thread only)
+ * ONECCL_BINDINGS_FOR_PYTORCH_ENV_COPY_NT_THRESHOLD: Default = 0, Bytes from which staging copies use non-temporal stores (0: 8MB, <0: never)
+ * ONECCL_BINDINGS_FOR_PYTORCH_ENV_PHASE_TIMER:       Default = 0, Set 1 to accumulate the time spent in each phase of the collectives
  */
 
 #define ONECCL_BINDINGS_FOR_PYTORCH_ENV_TYPE_DEF(var) \
@@ -20,6 +23,9 @@ int oneccl_bindings_for_pytorch_env(int env_type) {
   static struct {
     ONECCL_BINDINGS_FOR_PYTORCH_ENV_TYPE_DEF(ENV_VERBOSE);
     ONECCL_BINDINGS_FOR_PYTORCH_ENV_TYPE_DEF(ENV_WAIT_GDB);
+    ONECCL_BINDINGS_FOR_PYTORCH_ENV_TYPE_DEF(ENV_COPY_THREADS);
+    ONECCL_BINDINGS_FOR_PYTORCH_ENV_TYPE_DEF(ENV_COPY_NT_THRESHOLD);
+    ONECCL_BINDINGS_FOR_PYTORCH_ENV_TYPE_DEF(ENV_PHASE_TIMER);
   } env;
 
   switch (env_type) {
@@ -27,6 +33,12 @@ int oneccl_bindings_for_pytorch_env(int env_type) {
       return env.ENV_VERBOSE;
     case ENV_WAIT_GDB:
       return env.ENV_WAIT_GDB;
+    case ENV_COPY_THREADS:
+      return env.ENV_COPY_THREADS;
+    case ENV_COPY_NT_THRESHOLD:
+      return env.ENV_COPY_NT_THRESHOLD;
+    case ENV_PHASE_TIMER:
+      return env.ENV_PHASE_TIMER;
     default:
       return 0;
   }
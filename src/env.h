@@ -2,7 +2,10 @@
 
 enum ONECCL_BINDINGS_FOR_PYTORCH_ENV {
   ENV_VERBOSE = 0,
-  ENV_WAIT_GDB
+  ENV_WAIT_GDB,
+  ENV_COPY_THREADS,
+  ENV_COPY_NT_THRESHOLD,
+  ENV_PHASE_TIMER
 };
 
 int oneccl_bindings_for_pytorch_env(int env);
@@ -13,4 +16,16 @@ static inline int oneccl_bindings_for_pytorch_verbose() {
 
 static inline int oneccl_bindings_for_pytorch_wait_gdb() {
   return oneccl_bindings_for_pytorch_env(ENV_WAIT_GDB);
-}
\ No newline at end of file
+}
+
+static inline int oneccl_bindings_for_pytorch_copy_threads() {
+  return oneccl_bindings_for_pytorch_env(ENV_COPY_THREADS);
+}
+
+static inline int oneccl_bindings_for_pytorch_copy_nt_threshold() {
+  return oneccl_bindings_for_pytorch_env(ENV_COPY_NT_THRESHOLD);
+}
+
+static inline int oneccl_bindings_for_pytorch_phase_timer() {
+  return oneccl_bindings_for_pytorch_env(ENV_PHASE_TIMER);
+}
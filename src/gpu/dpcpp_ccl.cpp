@@ -267,15 +267,17 @@ Comms& get_ccl_comms(c10d::ProcessGroupCCL& pg_ccl, const std::string& devices_k
     throw std::runtime_error("Torch CCL only support one device per process now");
   }
 
+  // One snapshot, in case the group is aborted meanwhile.
+  auto member = pg_ccl.cclMember();
   if (pg_ccl.useSameStream_) {
       c10::impl::VirtualGuardImpl impl(devices[0].type());
       c10::Stream current_stream = impl.getStream(devices[0]);
-      auto cached_comms = pg_ccl.ccl_member_->get_comms(devices_key + "_" + std::to_string(current_stream.id()));
+      auto cached_comms = member->get_comms(devices_key + "_" + std::to_string(current_stream.id()));
       if (cached_comms) {
           return *cached_comms;
       }
   } else {
-     auto cached_comms = pg_ccl.ccl_member_->get_comms(devices_key); // stream is not in cache key
+     auto cached_comms = member->get_comms(devices_key); // stream is not in cache key
      if (cached_comms && use_llm_allreduce == last_use_llm_allreduce) {
          return *cached_comms;
      }
@@ -347,7 +349,7 @@ Comms& get_ccl_comms(c10d::ProcessGroupCCL& pg_ccl, const std::string& devices_k
   auto ctx = ccl::create_context(q.get_context());
 
   // Create ccl::communicators
-  auto dpcpp_comms = ccl::create_communicators(total_rank_size, devs_rank, ctx, pg_ccl.ccl_member_->get_kvs(pg_ccl.getRank(), *pg_ccl.store_));
+  auto dpcpp_comms = ccl::create_communicators(total_rank_size, devs_rank, ctx, member->get_kvs(pg_ccl.getRank(), *pg_ccl.store_));
 
   // Initialize allreducer only if use_llm_allreduce is set to nonzero.
   if (use_llm_allreduce != 0){
@@ -361,9 +363,9 @@ Comms& get_ccl_comms(c10d::ProcessGroupCCL& pg_ccl, const std::string& devices_k
   if (pg_ccl.useSameStream_) {
       auto torch_streams = dpcpp_comms_ptr->torch_streams;
       // Add stream id to cache. Then if new stream comes, new communicator will be created.
-      pg_ccl.ccl_member_->add_comms(devices_key + "_" + std::to_string(torch_streams[0].id()), dpcpp_comms_ptr);
+      member->add_comms(devices_key + "_" + std::to_string(torch_streams[0].id()), dpcpp_comms_ptr);
   } else {
-      pg_ccl.ccl_member_->add_comms(devices_key, dpcpp_comms_ptr);
+      member->add_comms(devices_key, dpcpp_comms_ptr);
   }
 
   return *dpcpp_comms_ptr.get();
@@ -658,16 +660,24 @@ void checkGPUTensor(const std::vector<at::Tensor>& tensors)
 }
 
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::execute(c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> & work){
+  // Blocks while the process group has too many collectives in flight.
+  work->acquireInflight();
   try {
+    ScopedPhase phase(Phase::SUBMIT);
     work->run();
   } catch (...) {
+    work->releaseInflight();
     work->finishAsyncWorkCCLError(std::current_exception());
     return work;
   }
   // mark the work finished asynchronizely.
-  work->finishAsyncWorkCCL();
+  {
+    ScopedPhase phase(Phase::FUTURE);
+    work->finishAsyncWorkCCL();
+  }
 
   // Track the work internal
+  ScopedPhase phase(Phase::QUEUE);
   std::unique_lock<std::mutex> lock(pgMutex_);
   queue_.push_back(work);
   lock.unlock();
@@ -707,12 +717,14 @@ void XPUCCLStubs::runLoop() {
     queueConsumeCV_.notify_one();
 
     try {
+      ScopedPhase phase(Phase::COMPLETION);
       work->synchronize();
 //      work->finishAsyncWorkCCL();
 
     } catch (...) {
 //      work->finishAsyncWorkCCLError(std::current_exception());
     }
+    work->releaseInflight();
 
     lock.lock();
   }
@@ -772,7 +784,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::allreduce_impl(st
                                             output.data_ptr(),
                                             (size_t) input.numel(),
                                             cclDatatypes.at(input.scalar_type()),
-                                            cclOps.at(opts.reduceOp),
+                                            get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                             comm,
                                             stream,
                                             attr));
@@ -830,7 +842,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::reduce_(std::vect
                                 output.data_ptr(),
                                 (size_t) input.numel(),
                                 cclDatatypes.at(input.scalar_type()),
-                                cclOps.at(opts.reduceOp),
+                                get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                 root,
                                 comm,
                                 stream));
@@ -872,7 +884,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::_reduce_oop(at::T
                                 output.data_ptr(),
                                 (size_t) input.numel(),
                                 cclDatatypes.at(input.scalar_type()),
-                                cclOps.at(opts.reduceOp),
+                                get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                 root,
                                 comm,
                                 stream));
@@ -921,7 +933,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::reduce_scatter_(s
                                                         output.data_ptr(),
                                                         (size_t) output.numel(),
                                                         cclDatatypes.at(input.scalar_type()),
-                                                        cclOps.at(opts.reduceOp),
+                                                        get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                                         comm,
                                                         stream));
                 });
@@ -988,7 +1000,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::_reduce_scatter_b
                                                       output.data_ptr(),
                                                       (size_t) output.numel(),
                                                       cclDatatypes.at(input.scalar_type()),
-                                                      cclOps.at(opts.reduceOp),
+                                                      get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                                       comm,
                                                       stream));
             });
@@ -1025,7 +1037,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::reduce_scatter_te
                                                       output.data_ptr(),
                                                       (size_t) output.numel(),
                                                       cclDatatypes.at(input.scalar_type()),
-                                                      cclOps.at(opts.reduceOp),
+                                                      get_ccl_reduction(opts.reduceOp, input.scalar_type()),
                                                       comm,
                                                       stream));
             });
@@ -1538,7 +1550,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::send_(std::vector
                                                                        int /* unused */,
                                                                        ProcessGroupCCL& pg_ccl) {
 
-  if (pg_ccl.ccl_member_->ccl_comms.size() == 0) {
+  if (pg_ccl.cclMember()->ccl_comms.size() == 0) {
     throw std::runtime_error("Point-to-point communication as the first call is not supported now, please make sure all communicators have been initilized. e.g. you could add collective call in front of dist.send/recv call to avoid this error.");
   }
 
@@ -1581,7 +1593,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::recv_(std::vector
                                                                        int /* unused */,
                                                                        ProcessGroupCCL& pg_ccl) {
 
-  if (pg_ccl.ccl_member_->ccl_comms.size() == 0) {
+  if (pg_ccl.cclMember()->ccl_comms.size() == 0) {
     throw std::runtime_error("Point-to-point communication as the first call is not supported now, please make sure all communicators have been initilized. e.g. you could add collective call in front of dist.send/recv call to avoid this error.");
   }
 
@@ -1622,15 +1634,20 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::recv_(std::vector
 c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> XPUCCLStubs::barrier_(const BarrierOptions& opts,
                                                                    ProcessGroupCCL& pg) {
 
+  TORCH_CHECK(!pg.aborted(), "The process group was aborted");
+  pg.checkNoChainInFlight();
   c10::intrusive_ptr<AsyncBarrierWork> work = c10::make_intrusive<AsyncBarrierWork>();
 
-  if (pg.ccl_member_->ccl_comms.size() == 0) {
+  auto member = pg.cclMember();
+  if (member->ccl_comms.size() == 0) {
     std::vector<at::Device> xpu_devices{at::Device(at::kXPU)};
     const auto key = get_key_from_devs(xpu_devices);
     get_ccl_comms(pg, key, xpu_devices);
   }
 
-  auto& comms_map = pg.ccl_member_->ccl_comms;
+  auto& comms_map = member->ccl_comms;
+  work->groupAborted_ = pg.groupAborted_;
+  work->markStarted();
   for(auto iter = comms_map.begin(); iter != comms_map.end(); iter++){
       for(size_t i =0 ; i < iter->second->comms.size(); i++){
          work->getEvents().emplace_back(
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "phase_timer.h"
+
+#include <array>
+
+#include "env.h"
+
+namespace oneccl_bindings_for_pytorch {
+
+namespace {
+
+constexpr int kNumPhases = static_cast<int>(Phase::NUM_PHASES);
+
+const char* kPhaseNames[kNumPhases] = {
+  "api",
+  "dispatch",
+  "validation",
+  "comm_lookup",
+  "work_construction",
+  "submit",
+  "queue",
+  "completion",
+  "future",
+};
+
+std::array<std::atomic<uint64_t>, kNumPhases> phase_counts{};
+std::array<std::atomic<uint64_t>, kNumPhases> phase_totals{};
+
+thread_local int phase_depth[kNumPhases] = {};
+
+} // namespace
+
+std::atomic<bool> phase_timer_on{oneccl_bindings_for_pytorch_phase_timer() != 0};
+
+void set_phase_timer_enabled(bool enabled) {
+  phase_timer_on.store(enabled, std::memory_order_relaxed);
+}
+
+void reset_phase_timer() {
+  for (int i = 0; i < kNumPhases; i++) {
+    phase_counts[i].store(0, std::memory_order_relaxed);
+    phase_totals[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void record_phase(Phase phase, uint64_t ns) {
+  auto idx = static_cast<int>(phase);
+  phase_counts[idx].fetch_add(1, std::memory_order_relaxed);
+  phase_totals[idx].fetch_add(ns, std::memory_order_relaxed);
+}
+
+std::vector<PhaseStats> get_phase_stats() {
+  std::vector<PhaseStats> stats;
+  stats.reserve(kNumPhases);
+  for (int i = 0; i < kNumPhases; i++) {
+    stats.push_back({kPhaseNames[i],
+                     phase_counts[i].load(std::memory_order_relaxed),
+                     phase_totals[i].load(std::memory_order_relaxed)});
+  }
+  return stats;
+}
+
+ScopedPhase::ScopedPhase(Phase phase) : phase_(phase), active_(phase_timer_enabled()) {
+  if (active_ && phase_depth[static_cast<int>(phase_)]++ == 0) {
+    start_ = std::chrono::steady_clock::now();
+  }
+}
+
+ScopedPhase::~ScopedPhase() {
+  if (active_ && --phase_depth[static_cast<int>(phase_)] == 0) {
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    record_phase(phase_, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+}
+
+} // namespace oneccl_bindings_for_pytorch
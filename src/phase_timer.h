@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace oneccl_bindings_for_pytorch {
+
+// Steps of a collective in the bindings, in the order they happen. The
+// scopes nest: API contains DISPATCH, which contains VALIDATION and the
+// device specific steps from COMM_LOOKUP to QUEUE. COMPLETION and FUTURE
+// run on the progress thread.
+enum class Phase : int {
+  API = 0,
+  DISPATCH,
+  VALIDATION,
+  COMM_LOOKUP,
+  WORK_CONSTRUCTION,
+  SUBMIT,
+  QUEUE,
+  COMPLETION,
+  FUTURE,
+  NUM_PHASES
+};
+
+struct PhaseStats {
+  std::string name;
+  uint64_t count;
+  uint64_t total_ns;
+};
+
+extern std::atomic<bool> phase_timer_on;
+
+inline bool phase_timer_enabled() {
+  return phase_timer_on.load(std::memory_order_relaxed);
+}
+
+void set_phase_timer_enabled(bool enabled);
+
+void reset_phase_timer();
+
+void record_phase(Phase phase, uint64_t ns);
+
+std::vector<PhaseStats> get_phase_stats();
+
+// Accumulates the time spent in the enclosing scope into the phase when the
+// timer is enabled. Only the outermost scope of a phase is counted on a
+// thread, so helpers calling each other are not counted twice.
+class ScopedPhase {
+public:
+  explicit ScopedPhase(Phase phase);
+  ~ScopedPhase();
+
+  ScopedPhase(const ScopedPhase&) = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+  Phase phase_;
+  bool active_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "recv_stream.h"
+
+#include <algorithm>
+
+namespace oneccl_bindings_for_pytorch {
+
+RecvStream::RecvStream(c10::intrusive_ptr<c10d::ProcessGroupCCL> pg,
+                       int peer,
+                       std::vector<int64_t> shape,
+                       at::TensorOptions options,
+                       int64_t depth,
+                       int64_t count)
+    : pg_(std::move(pg)), peer_(peer), count_(count) {
+  TORCH_CHECK(depth > 0, "depth must be positive, got ", depth);
+  if (count_ >= 0) {
+    depth = std::max<int64_t>(1, std::min(depth, count_));
+  }
+  for (int64_t i = 0; i < depth; i++) {
+    buffers_.push_back(at::empty(shape, options));
+  }
+  works_.resize(depth);
+  for (size_t i = 0; i < buffers_.size(); i++) {
+    post(i);
+  }
+}
+
+RecvStream::~RecvStream() {
+  for (auto& work : works_) {
+    if (!work) {
+      continue;
+    }
+    if (work->isCompleted()) {
+      work->finishAsyncWorkCCL();
+    } else {
+      // The transport may still write into the buffer, which the work keeps
+      // alive: never free a pending receive.
+      auto leaked = new c10::intrusive_ptr<c10d::ProcessGroupCCL::AsyncWorkCCL>(std::move(work));
+      (void) leaked;
+    }
+  }
+}
+
+void RecvStream::post(size_t slot) {
+  if (count_ >= 0 && posted_ >= count_) {
+    return;
+  }
+  std::vector<at::Tensor> tensors{buffers_[slot]};
+  works_[slot] = pg_->prepostRecv(tensors, peer_);
+  posted_++;
+}
+
+void RecvStream::complete(size_t slot) {
+  auto work = std::move(works_[slot]);
+  try {
+    work->synchronize();
+    work->finishAsyncWorkCCL();
+  } catch (...) {
+    work->finishAsyncWorkCCLError(std::current_exception());
+  }
+  // Rethrows the error of the receive, if any.
+  work->wait();
+}
+
+at::Tensor RecvStream::next() {
+  TORCH_CHECK(count_ < 0 || stats_.received < (uint64_t) count_,
+              "all the ", count_, " messages of the stream were received");
+  // The consumer is done with the previous message, post its buffer again.
+  if (lent_ >= 0) {
+    post(lent_);
+    lent_ = -1;
+  }
+
+  if (works_[head_]->isCompleted()) {
+    stats_.readyOnArrival++;
+    bool allReady = std::all_of(works_.begin(), works_.end(),
+                                [](auto& work) { return !work || work->isCompleted(); });
+    if (allReady && posted_ - (int64_t) stats_.received == (int64_t) works_.size()) {
+      stats_.senderAhead++;
+    }
+  } else {
+    auto start = std::chrono::steady_clock::now();
+    works_[head_]->synchronize();
+    stats_.waitNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+  complete(head_);
+
+  stats_.received++;
+  lent_ = head_;
+  head_ = (head_ + 1) % buffers_.size();
+  return buffers_[lent_];
+}
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "ProcessGroupCCL.hpp"
+
+namespace oneccl_bindings_for_pytorch {
+
+// A stream of messages of a fixed shape from one peer, e.g. the activations or
+// gradients of the microbatches of a pipeline stage. `depth` receives are kept
+// posted ahead of the consumer in a ring of preallocated buffers, so that the
+// sender finds a receive waiting instead of stalling, and the posting latency
+// is off the critical path.
+//
+// next() returns the messages in order. The returned tensor stays valid until
+// the next call to next(), which reposts its buffer. The messages between two
+// ranks are matched in the order they are posted, so a peer must not send
+// anything else to this rank while receives of a stream from it are posted.
+// With a `count`, e.g. the number of microbatches of a step, no receive is
+// posted past the last message. An unbounded stream (count < 0) keeps its
+// receives posted: they are abandoned, still posted, when it is destroyed.
+class RecvStream {
+public:
+  struct Stats {
+    // Messages handed to the consumer.
+    uint64_t received = 0;
+    // Messages which had already arrived when the consumer asked for them.
+    uint64_t readyOnArrival = 0;
+    // Times all the posted receives were complete when the consumer asked for
+    // the next message: the sender outran the posted receives, and either
+    // waited for a buffer or had its messages buffered by the transport.
+    uint64_t senderAhead = 0;
+    // Time the consumer waited for a message which had not arrived yet.
+    uint64_t waitNs = 0;
+  };
+
+  RecvStream(c10::intrusive_ptr<c10d::ProcessGroupCCL> pg,
+             int peer,
+             std::vector<int64_t> shape,
+             at::TensorOptions options,
+             int64_t depth,
+             int64_t count);
+
+  ~RecvStream();
+
+  at::Tensor next();
+
+  Stats stats() const {
+    return stats_;
+  }
+
+  void resetStats() {
+    stats_ = Stats();
+  }
+
+private:
+  void post(size_t slot);
+
+  void complete(size_t slot);
+
+  c10::intrusive_ptr<c10d::ProcessGroupCCL> pg_;
+  int peer_;
+  int64_t count_;
+  int64_t posted_ = 0;
+  std::vector<at::Tensor> buffers_;
+  std::vector<c10::intrusive_ptr<c10d::ProcessGroupCCL::AsyncWorkCCL>> works_;
+  // Slot of the next message, and of the one lent to the consumer, -1 if none.
+  size_t head_ = 0;
+  int64_t lent_ = -1;
+  Stats stats_;
+};
+
+} // namespace oneccl_bindings_for_pytorch
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "thread_rank_group.h"
+
+#include <sched.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace oneccl_bindings_for_pytorch {
+
+namespace {
+
+// Spins before yielding the core to the other threads.
+constexpr int kBarrierSpins = 1 << 14;
+
+int numaNodeCount() {
+  int count = 0;
+  while (std::ifstream("/sys/devices/system/node/node" + std::to_string(count) + "/cpulist").good()) {
+    count++;
+  }
+  return count;
+}
+
+// Parses a kernel cpu list, such as "0-3,8-11".
+bool parseCpuList(const std::string& list, cpu_set_t& cpus) {
+  CPU_ZERO(&cpus);
+  std::stringstream ss(list);
+  std::string range;
+  bool any = false;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+      CPU_SET(cpu, &cpus);
+      any = true;
+    }
+  }
+  return any;
+}
+
+} // namespace
+
+ThreadRankGroup::ThreadRankGroup(int localSize, c10::intrusive_ptr<c10d::ProcessGroupCCL> pg)
+        : localSize_(localSize), pg_(std::move(pg)) {
+  TORCH_CHECK(localSize > 0, "the number of ranks per process must be positive, got ", localSize);
+  slots_.resize(localSize);
+  outputs_.resize(localSize);
+}
+
+int ThreadRankGroup::size() const {
+  return (pg_ ? pg_->getSize() : 1) * localSize_;
+}
+
+int ThreadRankGroup::rank(int localRank) const {
+  TORCH_CHECK(localRank >= 0 && localRank < localSize_, "invalid local rank ", localRank);
+  return (pg_ ? pg_->getRank() : 0) * localSize_ + localRank;
+}
+
+int ThreadRankGroup::bindNumaNode(int localRank) {
+  int nodes = numaNodeCount();
+  if (nodes == 0) {
+    return -1;
+  }
+  int node = localRank % nodes;
+  std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  std::string list;
+  std::getline(file, list);
+  cpu_set_t cpus;
+  if (!parseCpuList(list, cpus)) {
+    return -1;
+  }
+  TORCH_CHECK(sched_setaffinity(0, sizeof(cpus), &cpus) == 0, "cannot bind local rank ", localRank,
+              " to the cores of NUMA node ", node);
+  return node;
+}
+
+void ThreadRankGroup::sync() {
+  auto generation = generation_.load(std::memory_order_acquire);
+  if (arrived_.fetch_add(1, std::memory_order_acq_rel) + 1 == localSize_) {
+    arrived_.store(0, std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    return;
+  }
+  for (int spins = 0; generation_.load(std::memory_order_acquire) == generation; spins++) {
+    if (spins >= kBarrierSpins) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void ThreadRankGroup::onLeader(int localRank, const std::function<void()>& fn) {
+  if (localRank == 0) {
+    error_ = nullptr;
+    try {
+      fn();
+    } catch (...) {
+      error_ = std::current_exception();
+    }
+  }
+  sync();
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void ThreadRankGroup::publish(int localRank, const at::Tensor& tensor) {
+  TORCH_CHECK(localRank >= 0 && localRank < localSize_, "invalid local rank ", localRank);
+  slots_[localRank] = tensor;
+  sync();
+  for (const auto& slot : slots_) {
+    TORCH_CHECK(slot.device().is_cpu() && slot.is_contiguous(),
+                "the tensors of a thread rank group must be contiguous CPU tensors");
+    TORCH_CHECK(slot.numel() == slots_[0].numel() && slot.scalar_type() == slots_[0].scalar_type(),
+                "the local ranks passed tensors of different sizes or types");
+  }
+  if (localRank == 0 && (!scratch_.defined() || scratch_.numel() != tensor.numel() ||
+                         scratch_.scalar_type() != tensor.scalar_type())) {
+    scratch_ = at::empty({tensor.numel()}, tensor.options());
+  }
+  sync();
+}
+
+void ThreadRankGroup::allreduce(int localRank, at::Tensor& tensor, c10d::ReduceOp op) {
+  TORCH_CHECK(op == c10d::ReduceOp::SUM || op == c10d::ReduceOp::PRODUCT || op == c10d::ReduceOp::MIN ||
+              op == c10d::ReduceOp::MAX, "unsupported reduction in a thread rank group");
+  publish(localRank, tensor);
+
+  // Each local rank reduces its slice of the tensors of the process.
+  const int64_t numel = scratch_.numel();
+  const int64_t chunk = (numel + localSize_ - 1) / localSize_;
+  const int64_t begin = std::min(numel, chunk * localRank);
+  const int64_t length = std::min(numel, begin + chunk) - begin;
+  if (length > 0) {
+    auto out = scratch_.narrow(0, begin, length);
+    out.copy_(slots_[0].view(-1).narrow(0, begin, length));
+    for (int r = 1; r < localSize_; r++) {
+      auto in = slots_[r].view(-1).narrow(0, begin, length);
+      if (op == c10d::ReduceOp::SUM) {
+        out.add_(in);
+      } else if (op == c10d::ReduceOp::PRODUCT) {
+        out.mul_(in);
+      } else if (op == c10d::ReduceOp::MIN) {
+        at::minimum_out(out, out, in);
+      } else {
+        at::maximum_out(out, out, in);
+      }
+    }
+  }
+  sync();
+
+  onLeader(localRank, [&]() {
+    if (multiProcess()) {
+      std::vector<at::Tensor> tensors{scratch_};
+      c10d::AllreduceOptions opts;
+      opts.reduceOp = op;
+      pg_->allreduce(tensors, opts)->wait();
+    }
+  });
+  tensor.view(-1).copy_(scratch_);
+  slots_[localRank] = at::Tensor();
+  // scratch_ must not be reused before every rank has its copy.
+  sync();
+}
+
+void ThreadRankGroup::allgather(int localRank, at::Tensor& output, const at::Tensor& input) {
+  // The inputs of the process are gathered in the output of local rank 0,
+  // which then gathers those of the other processes.
+  TORCH_CHECK(localRank >= 0 && localRank < localSize_, "invalid local rank ", localRank);
+  outputs_[localRank] = output;
+  publish(localRank, input);
+  // Checked by every local rank, so that they all fail together.
+  for (const auto& out : outputs_) {
+    TORCH_CHECK(out.numel() == input.numel() * size() && out.scalar_type() == input.scalar_type() &&
+                out.is_contiguous(), "output must be a contiguous tensor of the type of input with ",
+                size(), " times its elements");
+  }
+  const int64_t numel = input.numel();
+  if (localRank == 0) {
+    gathered_ = output.view(-1);
+  }
+  sync();
+
+  const int64_t processOffset = (pg_ ? pg_->getRank() : 0) * localSize_ * numel;
+  gathered_.narrow(0, processOffset + localRank * numel, numel).copy_(input.view(-1));
+  sync();
+
+  onLeader(localRank, [&]() {
+    if (multiProcess()) {
+      auto local = gathered_.narrow(0, processOffset, localSize_ * numel).clone();
+      pg_->_allgather_base(gathered_, local, c10d::AllgatherOptions())->wait();
+    }
+  });
+  if (localRank != 0) {
+    output.view(-1).copy_(gathered_);
+  }
+  slots_[localRank] = at::Tensor();
+  outputs_[localRank] = at::Tensor();
+  sync();
+  if (localRank == 0) {
+    gathered_ = at::Tensor();
+  }
+}
+
+void ThreadRankGroup::broadcast(int localRank, at::Tensor& tensor, int root) {
+  TORCH_CHECK(root >= 0 && root < size(), "invalid root ", root);
+  publish(localRank, tensor);
+  if (rank(localRank) == root) {
+    scratch_.copy_(tensor.view(-1));
+  }
+  sync();
+
+  onLeader(localRank, [&]() {
+    if (multiProcess()) {
+      std::vector<at::Tensor> tensors{scratch_};
+      c10d::BroadcastOptions opts;
+      opts.rootRank = root / localSize_;
+      pg_->broadcast(tensors, opts)->wait();
+    }
+  });
+  if (rank(localRank) != root) {
+    tensor.view(-1).copy_(scratch_);
+  }
+  slots_[localRank] = at::Tensor();
+  sync();
+}
+
+void ThreadRankGroup::barrier(int localRank) {
+  TORCH_CHECK(localRank >= 0 && localRank < localSize_, "invalid local rank ", localRank);
+  sync();
+  onLeader(localRank, [&]() {
+    if (multiProcess()) {
+      pg_->barrier()->wait();
+    }
+  });
+}
+
+} // namespace oneccl_bindings_for_pytorch
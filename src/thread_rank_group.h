@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <vector>
+
+#include "ProcessGroupCCL.hpp"
+
+namespace oneccl_bindings_for_pytorch {
+
+// Several ranks hosted by one process, each driven by its own thread, e.g.
+// one per socket for CPU tensor parallel inference, so that the ranks share
+// the model metadata and the interpreter. The collectives among the threads
+// of the process go through plain memory, synchronized by a spinning barrier,
+// and only the ranks of other processes are reached with oneCCL, through the
+// process group of the process, by its local rank 0.
+//
+// Rank `localRank` of the process with rank p of the process group is the
+// global rank p * localSize + localRank. Every local rank must call each
+// collective, with tensors of the same size and type, and in the same order.
+// The collectives block the calling thread until they complete.
+class ThreadRankGroup {
+public:
+  // Without a process group, the ranks of the process are the whole group.
+  ThreadRankGroup(int localSize, c10::intrusive_ptr<c10d::ProcessGroupCCL> pg);
+
+  int localSize() const {
+    return localSize_;
+  }
+
+  int size() const;
+
+  int rank(int localRank) const;
+
+  // Binds the calling thread to the cores of a NUMA node, localRank modulo
+  // the number of nodes, and returns the node, or -1 when the topology is
+  // unknown.
+  int bindNumaNode(int localRank);
+
+  void allreduce(int localRank, at::Tensor& tensor, c10d::ReduceOp op);
+
+  // output holds the inputs of all the ranks, in the order of the global ranks.
+  void allgather(int localRank, at::Tensor& output, const at::Tensor& input);
+
+  void broadcast(int localRank, at::Tensor& tensor, int root);
+
+  void barrier(int localRank);
+
+private:
+  // Publishes the tensor of the local rank and waits for the others, then
+  // checks that they all match, on every thread so that they fail together.
+  void publish(int localRank, const at::Tensor& tensor);
+
+  void sync();
+
+  // Runs fn on local rank 0, e.g. the collective across the processes, and
+  // makes every local rank fail with its error.
+  void onLeader(int localRank, const std::function<void()>& fn);
+
+  bool multiProcess() const {
+    return pg_ && pg_->getSize() > 1;
+  }
+
+  const int localSize_;
+  c10::intrusive_ptr<c10d::ProcessGroupCCL> pg_;
+  std::vector<at::Tensor> slots_;
+  // Outputs of the local ranks during an allgather, checked by all of them.
+  std::vector<at::Tensor> outputs_;
+  // Shared result of the collective in flight, owned by local rank 0.
+  at::Tensor scratch_;
+  // Output of local rank 0 during an allgather.
+  at::Tensor gathered_;
+  std::exception_ptr error_;
+  std::atomic<int> arrived_{0};
+  std::atomic<uint64_t> generation_{0};
+};
+
+} // namespace oneccl_bindings_for_pytorch
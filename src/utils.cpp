@@ -30,6 +30,7 @@
  */
 
 #include "utils.h"
+#include "phase_timer.h"
 
 namespace oneccl_bindings_for_pytorch {
 
@@ -55,8 +56,38 @@ std::map<at::ScalarType, ccl::datatype> cclDatatypes =
     {at::kDouble, ccl::datatype::float64},
     {at::kBFloat16, ccl::datatype::bfloat16},
     {at::kBool, ccl::datatype::uint8},
+#if TORCH_VERSION_MAJOR > 2 || (TORCH_VERSION_MAJOR == 2 && TORCH_VERSION_MINOR >= 3)
+    {at::kUInt16, ccl::datatype::uint16},
+    {at::kUInt32, ccl::datatype::uint32},
+    {at::kUInt64, ccl::datatype::uint64},
+#endif
+#if TORCH_VERSION_MAJOR > 2 || (TORCH_VERSION_MAJOR == 2 && TORCH_VERSION_MINOR >= 1)
+    // Moved as raw bytes, oneCCL has no fp8 type. See get_ccl_reduction.
+    {at::kFloat8_e4m3fn, ccl::datatype::uint8},
+    {at::kFloat8_e5m2, ccl::datatype::uint8},
+#endif
   };
 
+ccl::reduction get_ccl_reduction(const c10d::ReduceOp& op, at::ScalarType type) {
+#if TORCH_VERSION_MAJOR > 2 || (TORCH_VERSION_MAJOR == 2 && TORCH_VERSION_MINOR >= 1)
+  // oneCCL would reduce the raw bytes.
+  TORCH_CHECK(!at::isFloat8Type(type), "fp8 reductions are only supported by allreduce on CPU");
+#endif
+  if (type == at::kBool) {
+    if (op == ReduceOp::BAND)
+      return ccl::reduction::min;
+    if (op == ReduceOp::BOR)
+      return ccl::reduction::max;
+  }
+  auto it = cclOps.find(op);
+  TORCH_CHECK(it != cclOps.end(), "the reduce op is not supported by this collective for ", type, " tensors");
+  return it->second;
+}
+
+bool is_bitwise_op(const c10d::ReduceOp& op) {
+  return op == ReduceOp::BAND || op == ReduceOp::BOR || op == ReduceOp::BXOR;
+}
+
 // Get the key from the list of devices
 std::string get_key_from_devs(const std::vector<at::Device>& devices) {
   std::string key = DeviceTypeName(devices[0].type(), /* lower case */ true) + ":";
@@ -216,6 +247,7 @@ bool computeLengthsAndCheckAndGetFlat(
 
 void checkSingleTensorHelper(const at::Tensor& tensor)
 {
+  ScopedPhase phase(Phase::VALIDATION);
   TORCH_CHECK(tensor.is_sparse() || tensor.is_contiguous(), "input dense tensor has to be contiguous");
   TORCH_CHECK(!tensor.is_cuda(), "CUDA tensor detected and CCL doesn't support CUDA buffers");
   TORCH_CHECK(tensor.numel() >= 0, "input tensor numel should be non-negative");
@@ -223,6 +255,7 @@ void checkSingleTensorHelper(const at::Tensor& tensor)
 
 void checkSingleTensor(const std::vector<at::Tensor>& tensors)
 {
+  ScopedPhase phase(Phase::VALIDATION);
   TORCH_CHECK(tensors.size() == 1,
               "CCL process group does not support tensors count " + std::to_string(tensors.size()));
 
@@ -233,6 +266,7 @@ void checkSingleTensor(const std::vector<at::Tensor>& tensors)
 void checkSameType(const at::Tensor& tensor,
                    const std::vector<at::Tensor>& tensors)
 {
+  ScopedPhase phase(Phase::VALIDATION);
   for (size_t i = 0; i < tensors.size(); ++i)
   {
     TORCH_CHECK(tensors[i].scalar_type() == tensor.scalar_type(),
@@ -248,10 +282,50 @@ void checkSameType(const at::Tensor& tensor,
 void checkSameType(const at::Tensor& tensor,
                    const std::vector<std::vector<at::Tensor>>& tensors)
 {
+  ScopedPhase phase(Phase::VALIDATION);
   for (size_t i = 0; i < tensors.size(); ++i)
   {
     checkSameType(tensor, tensors[i]);
   }
 }
 
+void checkSameTypeOrCastable(const at::Tensor& tensor,
+                             const std::vector<at::Tensor>& tensors)
+{
+  ScopedPhase phase(Phase::VALIDATION);
+  for (size_t i = 0; i < tensors.size(); ++i)
+  {
+    if (tensors[i].scalar_type() != tensor.scalar_type()) {
+      TORCH_CHECK(tensor.device().is_cpu() &&
+                  at::isFloatingType(tensor.scalar_type()) &&
+                  at::isFloatingType(tensors[i].scalar_type()),
+                  "Tensors are not equal in data type");
+    }
+    TORCH_CHECK(tensors[i].device().type() == tensor.device().type(),
+                "Tensors are not in same device type. Expect: ", tensor.device().type(),
+                " But got: ", tensors[i].device().type());
+
+    checkSingleTensorHelper(tensors[i]);
+  }
+}
+
+void checkOutOfPlace(const std::vector<at::Tensor>& outputs,
+                     const std::vector<at::Tensor>& inputs)
+{
+  ScopedPhase phase(Phase::VALIDATION);
+  TORCH_CHECK(!inputs.empty() && outputs.size() == inputs.size(),
+              "Expected as many output tensors as input tensors, got ", outputs.size(), " and ", inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i)
+  {
+    TORCH_CHECK(outputs[i].scalar_type() == inputs[i].scalar_type(),
+                "Output tensor ", i, " is ", outputs[i].scalar_type(), " but its input is ", inputs[i].scalar_type());
+    TORCH_CHECK(outputs[i].numel() == inputs[i].numel(),
+                "Output tensor ", i, " has ", outputs[i].numel(), " elements but its input has ", inputs[i].numel());
+    TORCH_CHECK(outputs[i].device() == inputs[i].device(),
+                "Output tensor ", i, " is not on the device of its input");
+    checkSingleTensorHelper(inputs[i]);
+    checkSingleTensorHelper(outputs[i]);
+  }
+}
+
 }
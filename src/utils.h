@@ -46,9 +46,13 @@
 
 #include <ccl_comm_collector.h>
 #include "ProcessGroupCCL.hpp"
+#include "phase_timer.h"
 
 
 constexpr uint64_t kSynchronizeBusyWaitMicro = 10; // 50us
+// Time a synchronizing thread polls the CCL events with yields before it
+// starts sleeping between the polls.
+constexpr uint64_t kSynchronizeSpinMicro = 100;
 
 #define CCL_CHECK(cmd)                                               \
   do {                                                               \
@@ -85,6 +89,13 @@ using c10d::ProcessGroupCCL;
 extern std::map<c10d::ReduceOp, ccl::reduction> cclOps;
 extern std::map<at::ScalarType, ccl::datatype> cclDatatypes;
 
+// The oneCCL reduction of op for the data type. The logical AND/OR of bool
+// tensors are their MIN/MAX.
+ccl::reduction get_ccl_reduction(const c10d::ReduceOp& op, at::ScalarType type);
+
+// Whether op is BAND, BOR or BXOR.
+bool is_bitwise_op(const c10d::ReduceOp& op);
+
 // Get the deviceList String from the list of devices
 std::string get_key_from_devs(const std::vector<at::Device>& devices);
 
@@ -148,6 +159,7 @@ public:
         return false;
       }
     }
+    markCompleted();
     return true;
   }
 
@@ -158,19 +170,21 @@ public:
 
   bool wait(std::chrono::milliseconds timeout) override
   {
-    for(auto& event : events) {
-      call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
-          CCL_CHECK(event.wait());
-      });
+    while (!isCompleted()) {
+      if (aborted()) {
+        // Same as the collectives, never destroy a pending request.
+        auto leaked = new std::vector<ccl::event>(std::move(events));
+        (void) leaked;
+        events.clear();
+        TORCH_CHECK(false, "Barrier aborted.");
+      }
+      std::this_thread::sleep_for(
+              std::chrono::microseconds (kSynchronizeBusyWaitMicro));
     }
     events.clear();
+    markCompleted();
     return true;
   }
-
-  void abort() override
-  {
-    TORCH_CHECK(false, "ProcessGroupCCL::WorkCCL::abort not implemented");
-  }
   
   void run() override{
     TORCH_CHECK(false, "AsyncBarrierWork::run not implemented");
@@ -257,24 +271,33 @@ public:
   }
 
   bool isCompleted() override {
-    for(auto& ret : rets) {
+    for(size_t i = 0; i < rets.size(); i++) {
       bool flag;
-      ccl::event& req = get_event_from_ret_<ret_t>(ret);
+      ccl::event& req = get_event_from_ret_<ret_t>(rets[i]);
 
       try {
+        // Only test the event: a blocking wait under the global lock would
+        // stall every other group behind a collective that never completes.
         call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
-            req.wait();
-            flag = true;
+            CCL_CHECK(flag = req.test());
         });
+        if (!flag) {
+          return false;
+        }
+        // The events are tested in order, the outputs before i are already post-processed.
+        if (completionHook) {
+          std::lock_guard<std::mutex> hookLock(hookMutex_);
+          if (i >= retsHooked_) {
+            completionHook(i);
+            retsHooked_ = i + 1;
+          }
+        }
       } catch (...) {
         finishAsyncWorkCCLError(std::current_exception());
         return true;
       }
-
-      if (!flag) {
-        return false;
-      }
     }
+    markCompleted();
     return true;
   }
 
@@ -296,7 +319,12 @@ public:
     // Wait for the operation to complete.
     std::chrono::milliseconds workTimeout =
             timeout == kNoTimeout ? this->opTimeout_ : timeout;
+    auto spinEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(kSynchronizeSpinMicro);
     while (!isCompleted()) {
+      if (aborted()) {
+        abandonRets_();
+        TORCH_CHECK(false, "[Rank ", rank_, "] Collective operation aborted.");
+      }
       if (timedOut(workTimeout)) {
 
         auto currentTimepoint = std::chrono::steady_clock::now();
@@ -311,10 +339,15 @@ public:
                 " ran for ",
                 timeElapsed.count(),
                 " milliseconds before timing out.");
+        abandonRets_();
         TORCH_CHECK(false, exceptionMsg);
       }
-      std::this_thread::sleep_for(
-              std::chrono::microseconds (kSynchronizeBusyWaitMicro));
+      if (std::chrono::steady_clock::now() < spinEnd) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(
+                std::chrono::microseconds (kSynchronizeBusyWaitMicro));
+      }
     }
   }
 
@@ -322,6 +355,22 @@ public:
     synchronizeInternal(kNoTimeout);
   }
 
+  bool poll() override {
+    if (isCompleted()) {
+      return true;
+    }
+    if (aborted()) {
+      abandonRets_();
+      TORCH_CHECK(false, "[Rank ", rank_, "] Collective operation aborted.");
+    }
+    if (timedOut(opTimeout_)) {
+      abandonRets_();
+      TORCH_CHECK(false, "[Rank ", rank_, "] Caught collective operation timeout: ",
+                  " ran for more than ", opTimeout_.count(), " milliseconds.");
+    }
+    return false;
+  }
+
 protected:
   std::vector<ccl::event>& get_ccl_event()
   {
@@ -334,6 +383,8 @@ protected:
       auto& outputs = outputTensors_;
       for (size_t i = 0; i < inputs.size(); i++) {
         CCL_CHECK(rets.push_back(f(inputs[i], outputs[i], attr, comms.comms[i], comms.streams[i + INDEX]...)));
+        // The transfer starts with the first op handed to oneCCL.
+        markStarted();
       }
     }
     else {
@@ -354,6 +405,7 @@ protected:
       auto size = inputs.empty()?outputs.size():inputs.size();
       for (size_t i = 0; i < size; i++) {
         CCL_CHECK(rets.push_back(f(inputs[i], outputs[i], attr, comms.comms[0], comms.streams[0 + INDEX]...)));
+        markStarted();
       }
     }
     else {
@@ -367,6 +419,7 @@ protected:
       auto& outputs = outputTensors_;
       for (size_t i = 0; i < inputs.size(); i++) {
         CCL_CHECK(rets.push_back(f(inputs[i], outputs[i], attr, comms.comms[i], comms.streams[i], comms.torch_streams[i])));
+        markStarted();
       }
     }
     else {
@@ -382,6 +435,7 @@ protected:
       auto size = inputs.empty()?outputs.size():inputs.size();
       for (size_t i = 0; i < size; i++) {
         CCL_CHECK(rets.push_back(f(inputs[i], outputs[i], attr, comms.comms[i], comms.streams[i], comms.torch_streams[i])));
+        markStarted();
       }
     }
     else {
@@ -390,6 +444,16 @@ protected:
   }
 
 
+  // The CCL requests of a timed out or aborted work may never complete, and
+  // destroying them could block. They are intentionally leaked.
+  void abandonRets_() {
+    if (!rets.empty()) {
+      auto leaked = new std::vector<ret_t>(std::move(rets));
+      (void) leaked;
+      rets.clear();
+    }
+  }
+
   template <typename R, std::enable_if_t<is_tuple<R>::value, bool> = true>
   ccl::event& get_event_from_ret_(R& ret)
   {
@@ -412,6 +476,9 @@ protected:
   std::vector<ret_t> rets;
   std::vector<ccl::event> cclEvents_;
   std::chrono::time_point<std::chrono::steady_clock> workStartTime_;
+  // Number of outputs already passed to the completionHook.
+  size_t retsHooked_ = 0;
+  std::mutex hookMutex_;
 };
 
 template <typename RunF, typename CommType, typename InputType, typename OutputType, typename attr_t>
@@ -486,8 +553,7 @@ public:
 
       try {
         call_with_lock(c10d::ProcessGroupCCL::globalMutex, [&]() {
-            req.wait();
-            flag = true;
+            CCL_CHECK(flag = req.test());
         });
       } catch (...) {
         finishAsyncWorkCCLError(std::current_exception());
@@ -498,6 +564,7 @@ public:
         return false;
       }
     }
+    markCompleted();
     return true;
   }
 
@@ -519,7 +586,12 @@ public:
     // Wait for the operation to complete.
     std::chrono::milliseconds workTimeout =
             timeout == kNoTimeout ? this->opTimeout_ : timeout;
+    auto spinEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(kSynchronizeSpinMicro);
     while (!isCompleted()) {
+      if (aborted()) {
+        abandonRets_();
+        TORCH_CHECK(false, "[Rank ", rank_, "] Collective operation aborted.");
+      }
       if (timedOut(workTimeout)) {
 
         auto currentTimepoint = std::chrono::steady_clock::now();
@@ -534,10 +606,15 @@ public:
                 " ran for ",
                 timeElapsed.count(),
                 " milliseconds before timing out.");
+        abandonRets_();
         TORCH_CHECK(false, exceptionMsg);
       }
-      std::this_thread::sleep_for(
-              std::chrono::microseconds (kSynchronizeBusyWaitMicro));
+      if (std::chrono::steady_clock::now() < spinEnd) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(
+                std::chrono::microseconds (kSynchronizeBusyWaitMicro));
+      }
     }
   }
 
@@ -556,6 +633,8 @@ protected:
     if (rets.empty()) {
       for (size_t i = 0; i < inputs.size(); i++) {
         CCL_CHECK(rets.push_back(f(inputs[i], peer, attr, comms.comms[i], comms.streams[i + INDEX]...)));
+        // The transfer starts with the first op handed to oneCCL.
+        markStarted();
       }
     }
     else {
@@ -568,6 +647,7 @@ protected:
     if (rets.empty()) {
       for (size_t i = 0; i < inputs.size(); i++) {
         CCL_CHECK(rets.push_back(f(inputs[i], peer, attr, comms.comms[i], comms.streams[i + INDEX]...)));
+        markStarted();
       }
     }
     else {
@@ -580,6 +660,7 @@ protected:
     if (rets.empty()) {
       for (size_t i = 0; i < inputs.size(); i++) {
         CCL_CHECK(rets.push_back(f(inputs[i], peer, attr, comms.comms[i], comms.streams[i], comms.torch_streams[i])));
+        markStarted();
       }
     }
     else {
@@ -592,6 +673,7 @@ protected:
     if (rets.empty()) {
       for (size_t i = 0; i < inputs.size(); i++) {
         CCL_CHECK(rets.push_back(f(inputs[i], peer, attr, comms.comms[i], comms.streams[i], comms.torch_streams[i])));
+        markStarted();
       }
     }
     else {
@@ -600,6 +682,16 @@ protected:
   }
 
 
+  // The CCL requests of a timed out or aborted work may never complete, and
+  // destroying them could block. They are intentionally leaked.
+  void abandonRets_() {
+    if (!rets.empty()) {
+      auto leaked = new std::vector<ret_t>(std::move(rets));
+      (void) leaked;
+      rets.clear();
+    }
+  }
+
   template <typename R, std::enable_if_t<is_tuple<R>::value, bool> = true>
   ccl::event& get_event_from_ret_(R& ret)
   {
@@ -674,6 +766,8 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> collective(
   post_process post,
   c10d::OpType op_type,
   const char* prof_title = nullptr) {
+  TORCH_CHECK(!pg_ccl.aborted(), "The process group was aborted");
+  pg_ccl.checkNoChainInFlight();
   using traits = function_traits<fn>;
   using attr_t = typename traits::template arg<2>::type;
   attr_t attr = ccl::create_operation_attr<attr_t>();
@@ -691,19 +785,30 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> collective(
     }
   }
 
-  const auto key = get_key_from_devs(devices);
-  auto& comms = get_ccl_fn(pg_ccl, key, devices, c10d::OpType::UNKNOWN, 0, false);
+  Comms* comms;
+  {
+    ScopedPhase phase(Phase::COMM_LOOKUP);
+    const auto key = get_key_from_devs(devices);
+    comms = &get_ccl_fn(pg_ccl, key, devices, c10d::OpType::UNKNOWN, 0, false);
+  }
 
   if (pg_ccl.is_coalescing_) {
     pg_ccl.coalescedDevices_.push_back(devices[0]);
   }
 
+  ScopedPhase phase(Phase::WORK_CONSTRUCTION);
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
-  work = make_work_ccl<WorkCCL>(inputs, outputs, fun, comms, attr, pg_ccl.timeout, pg_ccl.getRank(), op_type, prof_title);
+  work = make_work_ccl<WorkCCL>(inputs, outputs, fun, *comms, attr, pg_ccl.timeout, pg_ccl.getRank(), op_type, prof_title);
 
   // Set appropriate work parameters.
   work->blockingWait_ = pg_ccl.blockingWait_;
   work->useSameStream_ = pg_ccl.useSameStream_;
+  // Only the collectives are throttled. A point-to-point op may wait for a
+  // matching op which the peer posts after it, so it never waits for a slot.
+  if (pg_ccl.inflightLimiter_->enabled()) {
+    work->inflightLimiter_ = pg_ccl.inflightLimiter_;
+  }
+  work->groupAborted_ = pg_ccl.groupAborted_;
   return work;
 }
 
@@ -721,6 +826,8 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> pointToPoint(
   post_process post,
   const char* prof_title = nullptr) {
 
+  TORCH_CHECK(!pg_ccl.aborted(), "The process group was aborted");
+  pg_ccl.checkNoChainInFlight();
   using traits = function_traits<fn>;
   using attr_t = typename traits::template arg<2>::type;
   attr_t attr = ccl::create_operation_attr<attr_t>();
@@ -754,6 +861,7 @@ c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> pointToPoint(
   c10::intrusive_ptr<ProcessGroupCCL::AsyncWorkCCL> work;
 
   work = make_work_p2p<WorkP2P>(inputs, outputs, peer, fun, comms, attr, pg_ccl.timeout, pg_ccl.getRank(), op_type, prof_title);
+  work->groupAborted_ = pg_ccl.groupAborted_;
 
   return work;
 }
@@ -828,4 +936,11 @@ void checkSameType(const at::Tensor& tensor, const std::vector<at::Tensor>& tens
 void checkSameType(const at::Tensor& tensor,
                    const std::vector<std::vector<at::Tensor>>& tensors);
 
+// Same as checkSameType, but allows the floating point types to differ on CPU,
+// for the collectives which cast the data on the fly.
+void checkSameTypeOrCastable(const at::Tensor& tensor, const std::vector<at::Tensor>& tensors);
+
+// Checks that each output of an out-of-place collective matches its input.
+void checkOutOfPlace(const std::vector<at::Tensor>& outputs, const std::vector<at::Tensor>& inputs);
+
 }
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "work_chain.h"
+
+#include "ccl_comm_collector.h"
+
+namespace oneccl_bindings_for_pytorch {
+
+namespace {
+
+struct ChainState {
+  c10::intrusive_ptr<c10d::ProcessGroupCCL> pg;
+  std::vector<ChainStep> steps;
+  size_t next = 0;
+  c10::intrusive_ptr<c10::ivalue::Future> future;
+
+  // The group is released before the future completes, so that its callbacks
+  // and waiters can issue ops on it right away.
+  void complete(std::vector<at::Tensor> outputs) {
+    pg->chainInFlight_ = false;
+    future->markCompleted(c10::IValue(outputs));
+  }
+
+  void fail(std::exception_ptr eptr) {
+    pg->chainInFlight_ = false;
+    future->setError(eptr);
+  }
+};
+
+void follow(const std::shared_ptr<ChainState>& state, c10::intrusive_ptr<c10d::C10D_Work> work);
+
+void onDone(const std::shared_ptr<ChainState>& state, c10d::C10D_Work& work, std::exception_ptr eptr) {
+  if (eptr) {
+    state->fail(eptr);
+    return;
+  }
+  try {
+    auto outputs = work.result();
+    if (state->next == state->steps.size()) {
+      state->complete(std::move(outputs));
+      return;
+    }
+    follow(state, state->steps[state->next++](outputs));
+  } catch (...) {
+    state->fail(std::current_exception());
+  }
+}
+
+void follow(const std::shared_ptr<ChainState>& state, c10::intrusive_ptr<c10d::C10D_Work> work) {
+  TORCH_CHECK(work, "a step of the chain returned no work");
+  if (auto cclWork = c10::dynamic_intrusive_pointer_cast<c10d::ProcessGroupCCL::AsyncWorkCCL>(work)) {
+    cclWork->addContinuation([state](c10d::ProcessGroupCCL::AsyncWorkCCL& done, std::exception_ptr eptr) {
+      onDone(state, done, eptr);
+    });
+    return;
+  }
+  // Works of other backends only have their future.
+  work->getFuture()->addCallback([state, work](c10::ivalue::Future& future) {
+    onDone(state, *work, future.hasError() ? future.exception_ptr() : nullptr);
+  });
+}
+
+} // namespace
+
+c10::intrusive_ptr<c10::ivalue::Future> chain(const c10::intrusive_ptr<c10d::ProcessGroupCCL>& pg,
+                                              c10::intrusive_ptr<c10d::C10D_Work> first,
+                                              std::vector<ChainStep> steps) {
+  TORCH_CHECK(pg->cclMember()->share_key.empty(),
+              "a chain needs a dedicated process group, which cannot share its communicators");
+  TORCH_CHECK(!pg->chainInFlight_.exchange(true), "a chain of ops is already in flight on the process group");
+  auto state = std::make_shared<ChainState>();
+  state->pg = pg;
+  state->steps = std::move(steps);
+  state->future = c10::make_intrusive<c10::ivalue::Future>(c10::ListType::create(c10::TensorType::get()));
+  follow(state, std::move(first));
+  return state->future;
+}
+
+c10::intrusive_ptr<c10::ivalue::Future> reduce_scatter_cast_allgather(
+        const c10::intrusive_ptr<c10d::ProcessGroupCCL>& pg,
+        const at::Tensor& input,
+        at::ScalarType dtype) {
+  const int64_t size = pg->getSize();
+  TORCH_CHECK(input.numel() % size == 0, "the number of elements of input, ", input.numel(),
+              ", must be a multiple of the group size ", size);
+  auto flat = input.contiguous().view(-1);
+  auto shard = at::empty({flat.numel() / size}, flat.options());
+  auto output = at::empty(input.sizes(), input.options().dtype(dtype));
+
+  std::vector<ChainStep> steps;
+  steps.push_back([pg, output](std::vector<at::Tensor>& reduced) mutable {
+    auto cast = reduced[0].to(output.scalar_type());
+    return pg->_allgather_base(output, cast, c10d::AllgatherOptions());
+  });
+  return chain(pg, pg->_reduce_scatter_base(shard, flat, c10d::ReduceScatterOptions()), std::move(steps));
+}
+
+} // namespace oneccl_bindings_for_pytorch
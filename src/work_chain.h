@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "ProcessGroupCCL.hpp"
+
+namespace oneccl_bindings_for_pytorch {
+
+// Chains of ops which follow each other on the progress thread, through the
+// continuations of the works, without going back to Python nor taking the GIL.
+//
+// The ranks must issue the collectives of a group in the same order, but each
+// one issues the next step of a chain when its own previous op completes, at a
+// different time. A chain therefore owns its process group until its future
+// completes: any other op issued on the group meanwhile, including the first
+// op of another chain, fails. Run the chains on a dedicated group, which does
+// not share its communicators either (setCommShareKey).
+
+// Issues the next op of a chain from the outputs of the previous one.
+using ChainStep = std::function<c10::intrusive_ptr<c10d::C10D_Work>(std::vector<at::Tensor>&)>;
+
+// Runs each step on the outputs of the previous op as soon as it completes,
+// starting from `first`, which must be the last op issued on pg and may have
+// completed already, in which case the first step is issued right away on the
+// calling thread. All the steps issue their op on pg. Returns a future completed with the outputs of the
+// last op, or with the first error, in which case the next steps are skipped.
+c10::intrusive_ptr<c10::ivalue::Future> chain(const c10::intrusive_ptr<c10d::ProcessGroupCCL>& pg,
+                                              c10::intrusive_ptr<c10d::C10D_Work> first,
+                                              std::vector<ChainStep> steps);
+
+// Reduce-scatters input, casts the reduced shard to dtype and allgathers it:
+// the low precision parameter or gradient sync of sharded optimizers. The
+// future holds the result, of the shape of input and of type dtype. pg must be
+// dedicated to chains, see above.
+c10::intrusive_ptr<c10::ivalue::Future> reduce_scatter_cast_allgather(
+        const c10::intrusive_ptr<c10d::ProcessGroupCCL>& pg,
+        const at::Tensor& input,
+        at::ScalarType dtype);
+
+} // namespace oneccl_bindings_for_pytorch
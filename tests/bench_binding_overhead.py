@@ -0,0 +1,112 @@
+import argparse
+import os
+import time
+
+import torch
+import torch.distributed as dist
+import torch.multiprocessing as mp
+
+import oneccl_bindings_for_pytorch
+from oneccl_bindings_for_pytorch import ccl_lib
+from torch.utils.cpp_extension import load
+
+parser = argparse.ArgumentParser(description='Latency added by the bindings on top of oneCCL')
+parser.add_argument('--sizes', type=str, default='1,256,4096', help='comma separated allreduce sizes in elements')
+parser.add_argument('--dtype', type=str, default='float32')
+parser.add_argument('--warm', type=int, default=100, help='#warmup')
+parser.add_argument('--iter', type=int, default=2000, help='#iteration')
+parser.add_argument('--world_size', type=int, default=2, help='ranks spawned when not launched by mpirun')
+args = parser.parse_args()
+
+# In the order they happen. 'api' contains 'dispatch', which contains the
+# next steps up to 'queue'. 'completion' and 'future' run on the progress thread.
+PHASES = ['api', 'dispatch', 'validation', 'comm_lookup', 'work_construction', 'submit', 'queue',
+          'completion', 'future']
+DISPATCH_CHILDREN = ['validation', 'comm_lookup', 'work_construction', 'submit', 'queue']
+
+
+def load_bench_ext():
+    """The baseline loops are a test-only extension, built against the sources
+    of the bindings and the oneCCL of the installed package."""
+    here = os.path.dirname(os.path.abspath(__file__))
+    package = os.path.dirname(oneccl_bindings_for_pytorch.__file__)
+    lib = os.path.join(package, 'lib')
+    return load(name='bench_binding_overhead_ext',
+                sources=[os.path.join(here, 'csrc', 'bench_binding_overhead.cpp')],
+                extra_include_paths=[os.path.join(here, '..', 'src'), os.path.join(package, 'include')],
+                extra_ldflags=['-L' + lib, '-loneccl_bindings_for_pytorch', '-lccl', '-Wl,-rpath,' + lib])
+
+
+def torch_allreduce(tensor, iters):
+    start = time.perf_counter()
+    for _ in range(iters):
+        dist.all_reduce(tensor)
+    return (time.perf_counter() - start) * 1e6 / iters
+
+
+def phase_breakdown(tensor, iters):
+    dist.barrier()
+    ccl_lib._reset_phase_timer()
+    ccl_lib._set_phase_timer_enabled(True)
+    torch_allreduce(tensor, iters)
+    ccl_lib._set_phase_timer_enabled(False)
+    stats = ccl_lib._get_phase_stats()
+    return {name: total / 1000.0 / max(count, 1) for name, (count, total) in stats.items()}
+
+
+def run(rank, world_size):
+    os.environ['RANK'] = str(rank)
+    os.environ['WORLD_SIZE'] = str(world_size)
+    os.environ.setdefault('MASTER_ADDR', '127.0.0.1')
+    os.environ.setdefault('MASTER_PORT', '29500')
+    dist.init_process_group('ccl')
+    pg = dist.group.WORLD._get_backend(torch.device('cpu'))
+    dtype = getattr(torch, args.dtype)
+    # Built by rank 0 first, then loaded from the cache by the others.
+    if rank == 0:
+        bench_ext = load_bench_ext()
+    dist.barrier()
+    if rank != 0:
+        bench_ext = load_bench_ext()
+
+    if rank == 0:
+        print('allreduce latency in us, {} ranks, {}'.format(world_size, args.dtype))
+        print('{:>8} {:>10} {:>10} {:>10} {:>12} {:>12}'.format(
+            'numel', 'raw', 'pg(c++)', 'torch', 'c++-raw', 'torch-c++'))
+
+    breakdowns = []
+    for numel in [int(s) for s in args.sizes.split(',')]:
+        tensor = torch.ones(numel, dtype=dtype)
+
+        bench_ext.raw_allreduce(pg, tensor, args.warm)
+        bench_ext.pg_allreduce(pg, tensor, args.warm)
+        torch_allreduce(tensor, args.warm)
+
+        dist.barrier()
+        raw = bench_ext.raw_allreduce(pg, tensor, args.iter)
+        dist.barrier()
+        cpp = bench_ext.pg_allreduce(pg, tensor, args.iter)
+        dist.barrier()
+        py = torch_allreduce(tensor, args.iter)
+        breakdowns.append((numel, phase_breakdown(tensor, args.iter)))
+
+        if rank == 0:
+            print('{:>8} {:>10.2f} {:>10.2f} {:>10.2f} {:>12.2f} {:>12.2f}'.format(
+                numel, raw, cpp, py, cpp - raw, py - cpp))
+
+    if rank == 0:
+        print('\nper-op time spent in each phase in us (torch.distributed path)')
+        print('{:>8} '.format('numel') + ' '.join('{:>12}'.format(p[:12]) for p in PHASES + ['dispatch(own)']))
+        for numel, phases in breakdowns:
+            own = phases['dispatch'] - sum(phases[p] for p in DISPATCH_CHILDREN)
+            print('{:>8} '.format(numel) + ' '.join('{:>12.2f}'.format(phases[p]) for p in PHASES) +
+                  ' {:>12.2f}'.format(own))
+
+    dist.destroy_process_group()
+
+
+if __name__ == '__main__':
+    if 'PMI_RANK' in os.environ.keys() and 'PMI_SIZE' in os.environ.keys():
+        run(int(os.environ['PMI_RANK']), int(os.environ['PMI_SIZE']))
+    else:
+        mp.spawn(run, args=(args.world_size,), nprocs=args.world_size)
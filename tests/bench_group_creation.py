@@ -0,0 +1,63 @@
+import argparse
+import os
+import time
+
+import torch
+import torch.distributed as dist
+import torch.multiprocessing as mp
+
+import oneccl_bindings_for_pytorch
+
+parser = argparse.ArgumentParser(description='Latency of the creation of node-local ccl groups')
+parser.add_argument('--world_size', type=int, default=4, help='ranks spawned on the local machine')
+parser.add_argument('--group_size', type=int, default=2, help='ranks of each group')
+parser.add_argument('--groups', type=int, default=20, help='groups created by each bootstrap')
+args = parser.parse_args()
+
+
+def create_groups(new_group):
+    # the first collective creates the communicators, and bootstraps the kvs
+    tensor = torch.ones(1)
+    times = []
+    for _ in range(args.groups):
+        for first in range(0, args.world_size, args.group_size):
+            ranks = list(range(first, min(first + args.group_size, args.world_size)))
+            start = time.perf_counter()
+            group = new_group(ranks)
+            if dist.get_rank() in ranks:
+                dist.all_reduce(tensor, group=group)
+                times.append(time.perf_counter() - start)
+    return times
+
+
+def run(rank, world_size):
+    os.environ['RANK'] = str(rank)
+    os.environ['WORLD_SIZE'] = str(world_size)
+    os.environ['LOCAL_WORLD_SIZE'] = str(world_size)
+    os.environ.setdefault('MASTER_ADDR', '127.0.0.1')
+    os.environ.setdefault('MASTER_PORT', '29500')
+    dist.init_process_group('ccl')
+    dist.all_reduce(torch.ones(1))
+
+    results = {}
+    for name, new_group in [('store', lambda ranks: dist.new_group(ranks, backend='ccl')),
+                            ('shm', oneccl_bindings_for_pytorch.new_local_group)]:
+        dist.barrier()
+        times = torch.tensor(create_groups(new_group), dtype=torch.double) * 1e3
+        # the slowest rank decides when a group is usable
+        dist.all_reduce(times, op=dist.ReduceOp.MAX)
+        results[name] = times
+
+    if rank == 0:
+        print('creation + first allreduce of {} groups of {} ranks, in ms'.format(
+            len(results['store']), args.group_size))
+        print('{:>10} {:>10} {:>10} {:>10}'.format('bootstrap', 'mean', 'median', 'max'))
+        for name, times in results.items():
+            print('{:>10} {:>10.3f} {:>10.3f} {:>10.3f}'.format(
+                name, times.mean().item(), times.median().item(), times.max().item()))
+
+    dist.destroy_process_group()
+
+
+if __name__ == '__main__':
+    mp.spawn(run, args=(args.world_size,), nprocs=args.world_size)
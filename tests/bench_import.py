@@ -0,0 +1,51 @@
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+parser = argparse.ArgumentParser(description='Cost of importing the bindings and creating the first process group')
+parser.add_argument('--repeat', type=int, default=5, help='#fresh interpreters per step')
+args = parser.parse_args()
+
+# Each step runs in a fresh interpreter, so that nothing is loaded yet.
+# 'torch' imports torch alone, 'bindings' adds oneccl_bindings_for_pytorch and
+# 'first_pg' also creates a single rank ccl group and runs one allreduce.
+CHILD = r'''
+import json, os, sys, time
+step = sys.argv[1]
+start = time.perf_counter()
+import torch
+if step != 'torch':
+    import oneccl_bindings_for_pytorch
+imported = time.perf_counter()
+if step == 'first_pg':
+    import torch.distributed as dist
+    os.environ['MASTER_ADDR'] = '127.0.0.1'
+    os.environ['MASTER_PORT'] = str(29500 + os.getpid() % 1000)
+    dist.init_process_group('ccl', rank=0, world_size=1)
+    dist.all_reduce(torch.ones(1))
+end = time.perf_counter()
+status = dict(line.split(':', 1) for line in open('/proc/self/status'))
+with open('/proc/self/maps') as maps:
+    xpu_loaded = 'liboneccl_bindings_for_pytorch_xpu' in maps.read()
+print(json.dumps({'import_ms': (imported - start) * 1000, 'total_ms': (end - start) * 1000,
+                  'rss_mb': int(status['VmRSS'].split()[0]) / 1024, 'threads': int(status['Threads']),
+                  'xpu_loaded': xpu_loaded}))
+'''
+
+
+def run(step):
+    out = subprocess.run([sys.executable, '-c', CHILD, step], check=True, capture_output=True, text=True).stdout
+    return json.loads(out.strip().splitlines()[-1])
+
+
+print('{:>10} {:>12} {:>12} {:>10} {:>8} {:>11}'.format('step', 'import(ms)', 'total(ms)', 'rss(MB)', 'threads',
+                                                         'xpu loaded'))
+for step in ['torch', 'bindings', 'first_pg']:
+    samples = [run(step) for _ in range(args.repeat)]
+    best = min(samples, key=lambda s: s['total_ms'])
+    print('{:>10} {:>12.1f} {:>12.1f} {:>10.1f} {:>8} {:>11}'.format(
+        step, min(s['import_ms'] for s in samples), best['total_ms'], best['rss_mb'], best['threads'],
+        str(best['xpu_loaded'])))
@@ -0,0 +1,178 @@
+import argparse
+import os
+import threading
+import time
+
+import torch
+import torch.distributed as dist
+
+parser = argparse.ArgumentParser(description='Compute/communication overlap efficiency')
+parser.add_argument('--device', type=str, default='cpu', choices=['cpu', 'xpu'])
+parser.add_argument('--compute', type=str, default='gemm', choices=['gemm', 'stream'],
+                    help='gemm: compute bound matmul, stream: memory bound triad')
+parser.add_argument('--gemm-size', type=int, default=1024, help='M=N=K of the gemm')
+parser.add_argument('--stream-size', type=int, default=1 << 24, help='number of elements of the triad')
+parser.add_argument('--collective', type=str, default='allreduce',
+                    choices=['allreduce', 'allgather', 'reduce_scatter'])
+parser.add_argument('--sizes', type=str, default='4K,64K,1M,16M,64M',
+                    help='comma separated message sizes in bytes, K/M suffixes allowed')
+parser.add_argument('--inflight', type=int, default=4, help='number of collectives in flight')
+parser.add_argument('--warm', type=int, default=5, help='#warmup')
+parser.add_argument('--iter', type=int, default=50, help='#iteration')
+parser.add_argument('--csv', action='store_true', default=False, help='print the results as csv')
+args = parser.parse_args()
+
+if 'PMI_RANK' in os.environ.keys() and 'PMI_SIZE' in os.environ.keys():
+    os.environ['RANK'] = str(os.environ.get('PMI_RANK', 0))
+    os.environ['WORLD_SIZE'] = str(os.environ.get('PMI_SIZE', 1))
+os.environ.setdefault('MASTER_ADDR', '127.0.0.1')
+os.environ.setdefault('MASTER_PORT', '29500')
+
+if args.device == 'xpu':
+    import intel_extension_for_pytorch
+import oneccl_bindings_for_pytorch
+
+dist.init_process_group('ccl')
+rank = dist.get_rank()
+size = dist.get_world_size()
+
+if args.device == 'xpu':
+    local_rank = int(os.environ.get('MPI_LOCALRANKID', os.environ.get('LOCAL_RANK', rank)))
+    device = 'xpu:{}'.format(local_rank)
+    torch.xpu.set_device(local_rank)
+else:
+    device = 'cpu'
+
+
+def sync():
+    if args.device == 'xpu':
+        torch.xpu.synchronize()
+
+
+def parse_size(s):
+    s = s.strip().upper()
+    if s.endswith('K'):
+        return int(s[:-1]) * 1024
+    if s.endswith('M'):
+        return int(s[:-1]) * 1024 * 1024
+    return int(s)
+
+
+def make_compute():
+    if args.compute == 'gemm':
+        a = torch.randn(args.gemm_size, args.gemm_size, device=device)
+        b = torch.randn(args.gemm_size, args.gemm_size, device=device)
+        c = torch.empty(args.gemm_size, args.gemm_size, device=device)
+        return lambda: torch.matmul(a, b, out=c)
+    a = torch.randn(args.stream_size, device=device)
+    b = torch.randn(args.stream_size, device=device)
+    c = torch.empty(args.stream_size, device=device)
+    return lambda: torch.add(a, b, alpha=2.0, out=c)
+
+
+def make_comm(nbytes):
+    numel = max(size, nbytes // 4 // size * size)
+    if args.collective == 'allreduce':
+        t = torch.ones(numel, device=device)
+        return lambda: dist.all_reduce(t, async_op=True)
+    if args.collective == 'allgather':
+        t = torch.ones(numel // size, device=device)
+        out = torch.empty(numel, device=device)
+        return lambda: dist.all_gather_into_tensor(out, t, async_op=True)
+    t = torch.ones(numel, device=device)
+    out = torch.empty(numel // size, device=device)
+    return lambda: dist.reduce_scatter_tensor(out, t, async_op=True)
+
+
+def run_compute(fn, iters, result):
+    start = time.perf_counter()
+    for _ in range(iters):
+        fn()
+    sync()
+    result['compute'] = time.perf_counter() - start
+
+
+def run_comm(fn, iters, result):
+    start = time.perf_counter()
+    works = []
+    for _ in range(iters):
+        works.append(fn())
+        if len(works) >= args.inflight:
+            works.pop(0).wait()
+    for work in works:
+        work.wait()
+    sync()
+    result['comm'] = time.perf_counter() - start
+
+
+def measure(compute_fn, comm_fn, iters):
+    # compute alone
+    alone = {}
+    dist.barrier()
+    run_compute(compute_fn, iters, alone)
+
+    # communication alone
+    dist.barrier()
+    run_comm(comm_fn, iters, alone)
+
+    # both at the same time, the ops release the GIL so the threads run concurrently
+    overlap = {}
+    dist.barrier()
+    start = time.perf_counter()
+    compute_thread = threading.Thread(target=run_compute, args=(compute_fn, iters, overlap))
+    compute_thread.start()
+    run_comm(comm_fn, iters, overlap)
+    compute_thread.join()
+    overlap['total'] = time.perf_counter() - start
+    return alone, overlap
+
+
+config = 'workers={} affinity={} omp={}'.format(os.environ.get('CCL_WORKER_COUNT', 'default'),
+                                                 os.environ.get('CCL_WORKER_AFFINITY', 'default'),
+                                                 os.environ.get('OMP_NUM_THREADS', 'default'))
+if rank == 0:
+    if args.csv:
+        print('collective,compute,bytes,ccl_worker_count,ccl_worker_affinity,omp_num_threads,'
+              'compute_alone_ms,comm_alone_ms,compute_overlap_ms,comm_overlap_ms,'
+              'compute_slowdown,comm_slowdown,overlap_efficiency')
+    else:
+        print('{} / {} with {} ranks, {}'.format(args.collective, args.compute, size, config))
+        print('{:>10} {:>12} {:>12} {:>12} {:>12} {:>10} {:>10} {:>10}'.format(
+            'bytes', 'compute(ms)', 'comm(ms)', 'compute*(ms)', 'comm*(ms)',
+            'compute x', 'comm x', 'overlap'))
+
+compute_fn = make_compute()
+for nbytes in [parse_size(s) for s in args.sizes.split(',')]:
+    comm_fn = make_comm(nbytes)
+    measure(compute_fn, comm_fn, args.warm)
+    alone, overlap = measure(compute_fn, comm_fn, args.iter)
+
+    # the slowest rank decides the step time
+    times = torch.tensor([alone['compute'], alone['comm'], overlap['compute'], overlap['comm'], overlap['total']],
+                         dtype=torch.double)
+    dist.all_reduce(times, op=dist.ReduceOp.MAX)
+    compute_alone, comm_alone, compute_overlap, comm_overlap, total = times.tolist()
+
+    compute_slowdown = compute_overlap / compute_alone
+    comm_slowdown = comm_overlap / comm_alone
+    # share of the shorter phase hidden behind the longer one, 1 is a perfect overlap
+    hidden = compute_alone + comm_alone - total
+    efficiency = max(0.0, hidden) / min(compute_alone, comm_alone)
+
+    if rank == 0:
+        per_iter = 1000.0 / args.iter
+        if args.csv:
+            print('{},{},{},{},{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f}'.format(
+                args.collective, args.compute, nbytes,
+                os.environ.get('CCL_WORKER_COUNT', ''), os.environ.get('CCL_WORKER_AFFINITY', ''),
+                os.environ.get('OMP_NUM_THREADS', ''),
+                compute_alone * per_iter, comm_alone * per_iter,
+                compute_overlap * per_iter, comm_overlap * per_iter,
+                compute_slowdown, comm_slowdown, efficiency))
+        else:
+            print('{:>10} {:>12.3f} {:>12.3f} {:>12.3f} {:>12.3f} {:>10.2f} {:>10.2f} {:>10.2f}'.format(
+                nbytes, compute_alone * per_iter, comm_alone * per_iter,
+                compute_overlap * per_iter, comm_overlap * per_iter,
+                compute_slowdown, comm_slowdown, efficiency))
+
+dist.destroy_process_group()
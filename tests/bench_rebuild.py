@@ -0,0 +1,51 @@
+import argparse
+import os
+import tempfile
+import time
+
+import torch
+import torch.distributed as dist
+import torch.multiprocessing as mp
+
+import oneccl_bindings_for_pytorch
+
+parser = argparse.ArgumentParser(description='Time to rebuild a ccl process group in place after a failure')
+parser.add_argument('--world_size', type=int, default=2, help='ranks spawned on the local machine')
+parser.add_argument('--generations', type=int, default=5, help='number of rebuilds')
+parser.add_argument('--numel', type=int, default=1 << 20, help='elements of the allreduce run by each generation')
+parser.add_argument('--hang', action='store_true', default=False,
+                    help='leave a collective pending on rank 0 before each rebuild, as after a peer failure')
+args = parser.parse_args()
+
+
+def run(rank, world_size, tmpdir):
+    tensor = torch.ones(args.numel)
+    timings = []
+    for gen in range(args.generations + 1):
+        # every generation rendezvous on a fresh store, as an elastic agent would do
+        store = dist.FileStore(os.path.join(tmpdir, 'store_{}'.format(gen)), world_size)
+
+        start = time.perf_counter()
+        if gen > 0 and args.hang and rank == 0:
+            # the peers never join this allreduce
+            dist.all_reduce(torch.ones(16), async_op=True)
+        oneccl_bindings_for_pytorch.rebuild_process_group(store, rank, world_size)
+        rebuilt = time.perf_counter()
+        dist.all_reduce(tensor)
+        first = time.perf_counter()
+
+        if gen > 0:
+            timings.append(((rebuilt - start) * 1e3, (first - rebuilt) * 1e3))
+        dist.barrier()
+
+    oneccl_bindings_for_pytorch.abort_process_group()
+    if rank == 0:
+        print('rebuild of {} ranks, in ms{}'.format(world_size, ', rank 0 hung' if args.hang else ''))
+        print('{:>10} {:>14} {:>18} {:>10}'.format('generation', 'abort+init', 'first allreduce', 'total'))
+        for gen, (rebuild, first) in enumerate(timings, 1):
+            print('{:>10} {:>14.2f} {:>18.2f} {:>10.2f}'.format(gen, rebuild, first, rebuild + first))
+
+
+if __name__ == '__main__':
+    with tempfile.TemporaryDirectory() as tmpdir:
+        mp.spawn(run, args=(args.world_size, tmpdir), nprocs=args.world_size)
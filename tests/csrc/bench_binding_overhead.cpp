@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2020-2021, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the Intel Corporation nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test-only extension of tests/bench_binding_overhead.py, built at run time
+// against the sources of the bindings: the loops of the latency baselines.
+
+#include <chrono>
+
+#include <torch/extension.h>
+
+#include "ProcessGroupCCL.hpp"
+#include "utils.h"
+
+namespace {
+
+using namespace oneccl_bindings_for_pytorch;
+
+double raw_allreduce(c10d::ProcessGroupCCL& pg, at::Tensor& tensor, int iters) {
+  TORCH_CHECK(iters > 0, "iters must be positive");
+  std::vector<at::Tensor> tensors{tensor};
+  checkSingleTensor(tensors);
+  TORCH_CHECK(tensor.device().is_cpu(), "the raw oneCCL benchmark only supports CPU tensors");
+
+  const auto key = get_key_from_devs(get_device_list(tensors));
+  auto comms = pg.cclMember()->get_comms(key);
+  if (!comms) {
+    // The communicator is created by the first collective of the group.
+    pg.allreduce(tensors)->wait();
+    comms = pg.cclMember()->get_comms(key);
+  }
+  TORCH_CHECK(comms && comms->comms.size() == 1, "no CPU communicator in the process group");
+
+  auto& comm = comms->comms[0];
+  auto attr = ccl::create_operation_attr<ccl::allreduce_attr>();
+  auto dtype = cclDatatypes.at(tensor.scalar_type());
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; i++) {
+    CCL_CHECK(ccl::allreduce(tensor.data_ptr(),
+                             tensor.data_ptr(),
+                             (size_t) tensor.numel(),
+                             dtype,
+                             ccl::reduction::sum,
+                             comm,
+                             attr).wait());
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::micro>(elapsed).count() / iters;
+}
+
+double pg_allreduce(c10d::ProcessGroupCCL& pg, at::Tensor& tensor, int iters) {
+  TORCH_CHECK(iters > 0, "iters must be positive");
+  std::vector<at::Tensor> tensors{tensor};
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iters; i++) {
+    pg.allreduce(tensors)->wait();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::micro>(elapsed).count() / iters;
+}
+
+} // namespace
+
+PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
+  m.def("raw_allreduce", &raw_allreduce,
+        py::arg("process_group"),
+        py::arg("tensor"),
+        py::arg("iters"),
+        py::call_guard<py::gil_scoped_release>());
+  m.def("pg_allreduce", &pg_allreduce,
+        py::arg("process_group"),
+        py::arg("tensor"),
+        py::arg("iters"),
+        py::call_guard<py::gil_scoped_release>());
+}
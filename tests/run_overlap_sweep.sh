@@ -0,0 +1,29 @@
+#!/bin/bash
+# Sweep bench_overlap.py over the oneCCL worker (progress thread) count and
+# their affinity. The message sizes are swept inside the benchmark.
+# usage: ./run_overlap_sweep.sh [ranks] [extra bench_overlap.py arguments]
+NP=${1:-2}
+shift $(( $# > 0 ? 1 : 0 ))
+
+CORES=$(nproc)
+CORES_PER_RANK=$((CORES / NP))
+
+echo "collective,compute,bytes,ccl_worker_count,ccl_worker_affinity,omp_num_threads,compute_alone_ms,comm_alone_ms,compute_overlap_ms,comm_overlap_ms,compute_slowdown,comm_slowdown,overlap_efficiency"
+
+for WORKERS in 1 2 4; do
+  # leave the last cores of each rank to the oneCCL workers, or let them float
+  PINNED=""
+  for ((r = 0; r < NP; r++)); do
+    for ((w = 1; w <= WORKERS; w++)); do
+      PINNED="${PINNED:+$PINNED,}$(((r + 1) * CORES_PER_RANK - w))"
+    done
+  done
+  OMP_THREADS=$((CORES_PER_RANK - WORKERS))
+
+  for AFFINITY in "$PINNED" "auto"; do
+    CCL_WORKER_COUNT=$WORKERS CCL_WORKER_AFFINITY=$AFFINITY OMP_NUM_THREADS=$OMP_THREADS \
+      mpirun -np $NP -genv CCL_WORKER_COUNT=$WORKERS -genv CCL_WORKER_AFFINITY=$AFFINITY \
+      -genv OMP_NUM_THREADS=$OMP_THREADS \
+      python -u bench_overlap.py --csv "$@" | grep -v "^collective"
+  done
+done
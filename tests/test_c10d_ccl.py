@@ -197,6 +197,283 @@ class ProcessGroupCCLTest(MultiProcessTestCase):
     def test_allreduce_basics_multi_xpu(self):
         self._test_allreduce_basics(lambda t: t.clone().xpu("xpu:{}".format(self.rank)))
     
+    def test_allreduce_bitwise(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        masks = [torch.randint(0, 1 << 62, (3 << 18,), generator=torch.Generator().manual_seed(r))
+                 for r in range(self.world_size)]
+        for op, fold in [(c10d.ReduceOp.BAND, torch.bitwise_and),
+                         (c10d.ReduceOp.BOR, torch.bitwise_or),
+                         (c10d.ReduceOp.BXOR, torch.bitwise_xor)]:
+            expected = reduce(fold, masks)
+            for dtype in (torch.int64, torch.uint8, torch.bool):
+                tensor = masks[self.rank].clone()
+                if dtype == torch.uint8:
+                    tensor, expected_t = tensor.to(dtype), reduce(fold, [m.to(dtype) for m in masks])
+                elif dtype == torch.bool:
+                    tensor, expected_t = tensor % 2 == 1, reduce(fold, [m % 2 == 1 for m in masks])
+                else:
+                    expected_t = expected
+                opts = c10d.AllreduceOptions()
+                opts.reduceOp = op
+                pg.allreduce([tensor], opts).wait()
+                self.assertEqual(tensor, expected_t)
+
+        opts = c10d.AllreduceOptions()
+        opts.reduceOp = c10d.ReduceOp.BOR
+        with self.assertRaisesRegex(RuntimeError, "integer and bool"):
+            pg.allreduce([torch.ones(4)], opts)
+
+    def test_extended_dtypes(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+
+        # complex, reduced as pairs of reals
+        t = torch.full((8,), complex(self.rank, 1), dtype=torch.complex64)
+        work = pg.allreduce([t])
+        work.wait()
+        self.assertEqual(t, torch.full((8,), complex(sum(range(self.world_size)), self.world_size),
+                                       dtype=torch.complex64))
+        # the work returns the complex tensors, not their real views
+        self.assertTrue(work.result()[0].is_complex())
+        self.assertTrue(work.get_future().value()[0].is_complex())
+        output = torch.empty(8 * self.world_size, dtype=torch.complex64)
+        work = pg._allgather_base(output, t)
+        work.wait()
+        self.assertTrue(work.result()[0].is_complex())
+
+        if hasattr(torch, "uint32"):
+            # values above the int32 range, built as int32 bit patterns
+            def uint32_values(rank):
+                return (torch.arange(8) + (1 << 31) + rank * 8 - (1 << 32)).to(torch.int32).view(torch.uint32)
+            t = uint32_values(self.rank)
+            pg.broadcast([t]).wait()
+            self.assertEqual(t.view(torch.int32), uint32_values(0).view(torch.int32))
+
+        if hasattr(torch, "float8_e4m3fn"):
+            for dtype in (torch.float8_e4m3fn, torch.float8_e5m2):
+                values = [torch.linspace(-2, 2, 3000) * (r + 1) for r in range(self.world_size)]
+                t = values[self.rank].to(dtype)
+                pg.allreduce([t]).wait()
+                # accumulated in fp32, rounded once
+                expected = sum(v.to(dtype).float() for v in values).to(dtype)
+                self.assertEqual(t.view(torch.uint8), expected.view(torch.uint8))
+
+                # moved byte exact
+                t = values[0].to(dtype) if self.rank == 0 else torch.zeros(3000, dtype=dtype)
+                pg.broadcast([t]).wait()
+                self.assertEqual(t.view(torch.uint8), values[0].to(dtype).view(torch.uint8))
+
+    def test_out_of_place(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        total = sum(range(1, self.world_size + 1))
+
+        inputs = [torch.full((5 + i,), self.rank + 1.) for i in range(3)]
+        outputs = [torch.zeros(5 + i) for i in range(3)]
+        pg._allreduce_out(outputs[:1], inputs[:1]).wait()
+        self.assertEqual(outputs[0], torch.full((5,), float(total)))
+        pg._allreduce_out(outputs, inputs).wait()
+        for i in range(3):
+            self.assertEqual(outputs[i], torch.full((5 + i,), float(total)))
+            self.assertEqual(inputs[i], torch.full((5 + i,), self.rank + 1.))
+
+        opts = c10d.ReduceOptions()
+        opts.rootRank = self.world_size - 1
+        outputs = [torch.zeros(5 + i) for i in range(3)]
+        pg._reduce_out(outputs, inputs, opts).wait()
+        expected = total if self.rank == opts.rootRank else 0.
+        for i in range(3):
+            self.assertEqual(outputs[i], torch.full((5 + i,), expected))
+            self.assertEqual(inputs[i], torch.full((5 + i,), self.rank + 1.))
+
+        opts = c10d.BroadcastOptions()
+        opts.rootRank = 0
+        outputs = [torch.zeros(5 + i) for i in range(3)]
+        pg._broadcast_out(outputs, inputs, opts).wait()
+        for i in range(3):
+            self.assertEqual(outputs[i], torch.full((5 + i,), 1.))
+            self.assertEqual(inputs[i], torch.full((5 + i,), self.rank + 1.))
+
+        with self.assertRaisesRegex(RuntimeError, "elements"):
+            pg._allreduce_out([torch.zeros(4)], [torch.zeros(5)])
+
+    def test_ring_exchange(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        prev = (self.rank - 1) % self.world_size
+        next = (self.rank + 1) % self.world_size
+
+        k, v = torch.full((6,), float(self.rank)), torch.full((3, 2), self.rank * 10.)
+        recv_k, recv_v = torch.empty_like(k), torch.empty_like(v)
+        pg._ring_exchange([k, v], [recv_k, recv_v], [], []).wait()
+        self.assertEqual(recv_k, torch.full((6,), float(prev)))
+        self.assertEqual(recv_v, torch.full((3, 2), prev * 10.))
+
+        # both directions at once
+        from_prev, from_next = torch.empty_like(k), torch.empty_like(k)
+        pg._ring_exchange([k], [from_prev], [k * 2], [from_next]).wait()
+        self.assertEqual(from_prev, torch.full((6,), float(prev)))
+        self.assertEqual(from_next, torch.full((6,), next * 2.))
+
+    def test_reduce_scatter_cast_allgather(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        tensor = torch.ones(4 * self.world_size, 3) * (self.rank + 1)
+        future = oneccl_bindings_for_pytorch.reduce_scatter_cast_allgather(pg, tensor, torch.bfloat16)
+        # a Python callback after the native chain
+        result = future.then(lambda f: f.value()[0] * 2).wait()
+        expected = sum(range(1, self.world_size + 1)) * 2
+        self.assertEqual(result, torch.full((4 * self.world_size, 3), expected, dtype=torch.bfloat16))
+        # the group is released once the chain completes
+        pg.allreduce([torch.ones(1)]).wait()
+
+        # a first op which has already completed issues the next step on the calling thread
+        shard = torch.full((3,), float(self.rank))
+        work = pg._reduce_scatter_base(shard, torch.ones(3 * self.world_size))
+        work.wait()
+        output = torch.empty(3 * self.world_size)
+        future = oneccl_bindings_for_pytorch._C._chain_allgather(pg, work, output)
+        self.assertEqual(future.wait()[0], torch.full((3 * self.world_size,), float(self.world_size)))
+        pg.allreduce([torch.ones(1)]).wait()
+
+        # the input must split evenly among the ranks
+        with self.assertRaisesRegex(RuntimeError, "multiple of the group size"):
+            oneccl_bindings_for_pytorch.reduce_scatter_cast_allgather(pg, torch.ones(self.world_size + 1),
+                                                                      torch.bfloat16)
+
+    def test_thread_rank_group(self):
+        import threading
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        group = oneccl_bindings_for_pytorch.ThreadRankGroup(3, pg)
+        size = group.size()
+        self.assertEqual(size, 3 * self.world_size)
+        results = {}
+
+        def run(local_rank):
+            rank = group.rank(local_rank)
+            tensor = torch.full((5, 7), rank + 1.)
+            group.allreduce(local_rank, tensor)
+            maximum = torch.tensor([rank])
+            group.allreduce(local_rank, maximum, c10d.ReduceOp.MAX)
+            gathered = torch.empty(size * 2, dtype=torch.long)
+            group.allgather(local_rank, gathered, torch.tensor([rank, -rank]))
+            broadcast = torch.tensor([rank])
+            group.broadcast(local_rank, broadcast, size - 1)
+            group.barrier(local_rank)
+            results[rank] = (tensor, maximum, gathered, broadcast)
+
+        threads = [threading.Thread(target=run, args=(i,)) for i in range(group.local_size)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        self.assertEqual(sorted(results), [self.rank * 3 + i for i in range(3)])
+        for tensor, maximum, gathered, broadcast in results.values():
+            self.assertEqual(tensor, torch.full((5, 7), size * (size + 1) / 2))
+            self.assertEqual(maximum, torch.tensor([size - 1]))
+            self.assertEqual(gathered, torch.tensor([[r, -r] for r in range(size)]).view(-1))
+            self.assertEqual(broadcast, torch.tensor([size - 1]))
+
+        # a bad output on one local rank fails all of them instead of hanging the others
+        errors = {}
+
+        def bad_allgather(local_rank):
+            output = torch.empty(size * 2 - (local_rank == 1), dtype=torch.long)
+            try:
+                group.allgather(local_rank, output, torch.tensor([0, 0]))
+            except RuntimeError as e:
+                errors[local_rank] = str(e)
+
+        threads = [threading.Thread(target=bad_allgather, args=(i,)) for i in range(group.local_size)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(sorted(errors), [0, 1, 2])
+        self.assertTrue(all("times its elements" in e for e in errors.values()))
+
+    def test_delta_broadcast(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        root = self.world_size - 1
+        weights = [torch.randn(1000), torch.randn(30, 7, dtype=torch.double), torch.arange(50)]
+        tensors = [w.clone() if self.rank == root else torch.zeros_like(w) for w in weights]
+
+        broadcaster = oneccl_bindings_for_pytorch.DeltaBroadcaster(pg, tensors, root=root, block_size=100)
+        broadcaster.broadcast_delta()
+        for t, w in zip(tensors, weights):
+            self.assertEqual(t, w, atol=0, rtol=0)
+
+        # only the block of the change is sent
+        if self.rank == root:
+            tensors[0][150] += 1
+        broadcaster.broadcast_delta()
+        broadcaster.broadcast_delta()
+        self.assertEqual(tensors[0][150], weights[0][150] + 1)
+        stats = broadcaster.stats()
+        self.assertEqual((stats["broadcasts"], stats["full_refreshes"]), (3, 1))
+        self.assertEqual(stats["blocks_sent"], 10 + 3 + 1 + 1)
+
+        # quantized deltas, with the error sent by a full refresh
+        tensors = [w.clone() if self.rank == root else torch.zeros_like(w) for w in weights[:2]]
+        broadcaster = oneccl_bindings_for_pytorch.DeltaBroadcaster(pg, tensors, root=root, block_size=100,
+                                                                   quant_bits=8, refresh_every=2)
+        broadcaster.broadcast_delta()
+        if self.rank == root:
+            tensors[0].add_(0.01)
+        broadcaster.broadcast_delta()
+        self.assertEqual(tensors[0], weights[0] + 0.01, atol=0.01, rtol=0)
+        broadcaster.broadcast_delta()
+        broadcaster.broadcast_delta()
+        self.assertEqual(broadcaster.stats()["full_refreshes"], 2)
+        self.assertEqual(tensors[0], weights[0] + 0.01, atol=0, rtol=0)
+
+        # the tensors of the other ranks must have the layout of those of the root
+        tensors = [torch.zeros(1000 if self.rank == root else 999)]
+        if self.rank == root:
+            oneccl_bindings_for_pytorch.DeltaBroadcaster(pg, tensors, root=root, block_size=100)
+        else:
+            with self.assertRaisesRegex(RuntimeError, "do not match"):
+                oneccl_bindings_for_pytorch.DeltaBroadcaster(pg, tensors, root=root, block_size=100)
+
+    def test_recv_stream(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        pg.allreduce([torch.zeros(1)]).wait()
+        microbatches = 6
+
+        if self.rank == 0:
+            works = [pg.send([torch.full((4, 3), float(i))], 1, 0) for i in range(microbatches)]
+            for work in works:
+                work.wait()
+        elif self.rank == 1:
+            stream = oneccl_bindings_for_pytorch.RecvStream(pg, 0, torch.empty(4, 3), depth=2,
+                                                            count=microbatches)
+            for i in range(microbatches):
+                self.assertEqual(stream.next(), torch.full((4, 3), float(i)))
+            self.assertEqual(stream.stats()["received"], microbatches)
+            with self.assertRaisesRegex(RuntimeError, "were received"):
+                stream.next()
+
+    def test_recv_does_not_delay_later_ops(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        # the sender only sends once the allreduce issued after the receive completed
+        if self.rank == 1:
+            received = torch.empty(3)
+            recv = pg.recv([received], 0, 0)
+        total = torch.ones(1)
+        pg.allreduce([total]).wait()
+        self.assertEqual(total, torch.full((1,), float(self.world_size)))
+        if self.rank == 0:
+            pg.send([torch.arange(3.)], 1, 0).wait()
+        elif self.rank == 1:
+            recv.wait()
+            self.assertEqual(received, torch.arange(3.))
+
     def _test_allreduce_coalesced_basics(self, fn):
         store = c10d.FileStore(self.file_name, self.world_size)
         pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
@@ -528,6 +805,23 @@ class ProcessGroupCCLTest(MultiProcessTestCase):
     def test_alltoall_basics_multi_xpu(self):
         self._test_all_to_all_helper(lambda t: t.clone().xpu("xpu:{}".format(self.rank)))
 
+    def test_alltoall_staging_copy(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        size = self.world_size
+
+        # Per peer sizes below the parallel copy size (256KB in total), between
+        # it and the non-temporal threshold (8MB), and above both. The odd
+        # counts leave the chunks unaligned to the pages.
+        for count in [1001, 100003, 2500001]:
+            in_tensors = [torch.arange(count, dtype=torch.int64) + (self.rank * size + i) * count
+                          for i in range(size)]
+            out_tensors = [torch.empty(count, dtype=torch.int64) for _ in range(size)]
+            pg.alltoall(out_tensors, in_tensors).wait()
+            for i in range(size):
+                expected = torch.arange(count, dtype=torch.int64) + (i * size + self.rank) * count
+                self.assertEqual(out_tensors[i], expected)
+
     def _test_reduce_scatter_base_basics(self, fn):
         store = c10d.FileStore(self.file_name, self.world_size)
         pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
@@ -575,6 +869,245 @@ class ProcessGroupCCLTest(MultiProcessTestCase):
     @skip_if_not_multixpu
     def test_reduce_scatter_base_multi_xpu(self):
         self._test_reduce_scatter_base_ops(lambda t: t.clone().xpu("xpu:{}".format(self.rank)))
+
+    def test_allgather_base_cast(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+
+        # fp32 shard gathered into a bf16 output, the cast is done by the collective
+        input_t = torch.full([4], self.rank + 0.5, dtype=torch.float)
+        output_t = torch.empty([4 * self.world_size], dtype=torch.bfloat16)
+        pg._allgather_base(output_t, input_t).wait()
+
+        expected = torch.cat([torch.full([4], r + 0.5) for r in range(self.world_size)])
+        self.assertEqual(output_t, expected.to(torch.bfloat16))
+
+    def test_allgather_base_quantized(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+
+        for bits in [8, 4]:
+            pg._set_allgather_quantization(bits, block_size=32)
+            input_t = torch.linspace(-1, 1, 100) * (self.rank + 1)
+            output_t = torch.empty([100 * self.world_size], dtype=torch.bfloat16)
+            pg._allgather_base(output_t, input_t).wait()
+
+            expected = torch.cat([torch.linspace(-1, 1, 100) * (r + 1) for r in range(self.world_size)])
+            # the error is bounded by half of the quantization step of each block
+            step = (self.world_size / (127 if bits == 8 else 7))
+            self.assertEqual(output_t.float(), expected, atol=step / 2 + 1e-2, rtol=0)
+        pg._set_allgather_quantization(0)
+
+    def test_lossless_compression(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        pg._set_lossless_compression(True)
+
+        torch.manual_seed(self.rank)
+        # indices with small deltas over several batches of chunks, a sparse mask, ReLU outputs,
+        # and random data below the minimum size, which is sent uncompressed
+        shards = [torch.cumsum(torch.randint(0, 5, [700000]), 0) + self.rank,
+                  torch.rand([300000]) > 0.95,
+                  torch.relu(torch.randn([4000, 33])),
+                  torch.randn([777], dtype=torch.double)]
+        for shard in shards:
+            output_t = torch.empty([self.world_size * shard.numel()], dtype=shard.dtype)
+            pg._allgather_base(output_t, shard).wait()
+            # the list allgather is not compressed
+            gathered = [torch.empty_like(shard) for _ in range(self.world_size)]
+            pg.allgather([gathered], [shard]).wait()
+            self.assertEqual(output_t, torch.cat([g.view(-1) for g in gathered]), atol=0, rtol=0)
+
+            broadcast = shard.clone() if self.rank == 0 else torch.zeros_like(shard)
+            pg.broadcast([broadcast], c10d.BroadcastOptions()).wait()
+            self.assertEqual(broadcast, gathered[0], atol=0, rtol=0)
+        pg._set_lossless_compression(False)
+
+    def test_allgather_prefetcher(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+
+        shards = [torch.full([n], float(self.rank * 10 + i)) for i, n in enumerate([4, 7, 1, 5, 3])]
+        for prefetch in [0, 1, 2]:
+            prefetcher = oneccl_bindings_for_pytorch.AllgatherPrefetcher(pg, shards, prefetch)
+            for _ in range(2):
+                for i, shard in enumerate(shards):
+                    expected = torch.cat([torch.full([shard.numel()], float(r * 10 + i))
+                                          for r in range(self.world_size)])
+                    self.assertEqual(prefetcher.get(i), expected)
+                prefetcher.reset()
+            with self.assertRaisesRegex(RuntimeError, "in order"):
+                prefetcher.get(3)
+
+    def test_collective_matmul(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        torch.manual_seed(0)
+        weight = torch.randn(16, 8)
+        shards = [torch.randn(10, 16) for _ in range(self.world_size)]
+        x = torch.cat(shards)
+
+        for chunks in [1, 3, 4, 20]:
+            out = oneccl_bindings_for_pytorch.allgather_matmul(pg, shards[self.rank], weight, chunks)
+            self.assertEqual(out, x @ weight)
+
+            # every rank holds the same input, the reduced rows are scaled by the world size
+            out = oneccl_bindings_for_pytorch.matmul_reduce_scatter(pg, x, weight, chunks)
+            self.assertEqual(out, (shards[self.rank] @ weight) * self.world_size)
+
+    def test_network_simulator(self):
+        from oneccl_bindings_for_pytorch import simulator
+        store = c10d.FileStore(self.file_name, self.world_size)
+        c10d.init_process_group(backend="ccl", store=store, rank=self.rank, world_size=self.world_size)
+        trace = []
+        with simulator.record_comm_trace(trace):
+            c10d.all_reduce(torch.ones(1000))
+            c10d.all_gather_into_tensor(torch.empty(100 * self.world_size), torch.ones(100))
+            c10d.barrier()
+        self.assertEqual([(e['op'], e['bytes'], e['group_size']) for e in trace],
+                         [('allreduce', 4000, self.world_size), ('allgather', 400 * self.world_size, self.world_size),
+                          ('barrier', 0, self.world_size)])
+
+        network = simulator.Network(8, simulator.Link(1e-6, 50e9), simulator.Link(5e-6, 12.5e9))
+        # ring allreduce: 2 (p - 1) latencies and 2 (p - 1) / p of the data on the fabric
+        results = simulator.simulate(trace, 256, network, {'allreduce': 'ring'})
+        self.assertEqual(results[0][2], 256)
+        self.assertAlmostEqual(results[0][3], 2 * 255 * 5e-6 + 2 * 255 / 256 * 4000 / 12.5e9)
+        # more ranks, more time
+        smaller = simulator.simulate(trace, 16, network, {'allreduce': 'ring'})
+        self.assertLess(sum(r[3] for r in smaller), sum(r[3] for r in results))
+
+    def test_sharded_checkpoint(self):
+        from oneccl_bindings_for_pytorch import checkpoint
+        store = c10d.FileStore(self.file_name, self.world_size)
+        c10d.init_process_group(backend="ccl", store=store, rank=self.rank, world_size=self.world_size)
+        path = os.path.join(os.path.dirname(self.file_name), "ckpt_" + os.path.basename(self.file_name))
+        state = {"weight": torch.arange(1000 * (self.rank + 1), dtype=torch.float).view(-1, 10),
+                 "step": torch.tensor(self.rank, dtype=torch.long),
+                 "mask": torch.ones(7, dtype=torch.bool),
+                 # after the 7 bytes of the mask, needs an aligned offset to be viewed as bf16
+                 "bias": torch.arange(5, dtype=torch.bfloat16),
+                 "empty": torch.empty(0, dtype=torch.bfloat16)}
+        # small chunks so the shards are pipelined through the buffers of the aggregator
+        checkpoint.save_sharded(state, path, ranks_per_aggregator=self.world_size, chunk_bytes=1000, align=4096)
+        self.assertEqual(sorted(os.listdir(path)), ["agg_00000.bin", "index.json"])
+        loaded = checkpoint.load_sharded(path, chunk_bytes=1000)
+        self.assertEqual(sorted(loaded), sorted(state))
+        for name in state:
+            self.assertEqual(loaded[name].dtype, state[name].dtype)
+            self.assertEqual(loaded[name], state[name])
+
+        # a truncated file fails on every rank, not only on its aggregator
+        if self.rank == 0:
+            os.truncate(os.path.join(path, "agg_00000.bin"), 100)
+        with self.assertRaises((EOFError, RuntimeError)):
+            checkpoint.load_sharded(path, chunk_bytes=1000)
+
+    def test_grad_bucket_scheduler(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        params = [torch.empty(n) for n in (1000, 200000, 100000, 5)] + [torch.empty(10, dtype=torch.double)]
+        scheduler = oneccl_bindings_for_pytorch.GradBucketScheduler(pg, params, bucket_cap_mb=1,
+                                                                    first_bucket_cap_mb=1)
+        # the data type and the caps split the buckets
+        self.assertEqual([scheduler.bucket_of(i) for i in range(len(params))], [0, 0, 1, 1, 2])
+
+        for step in range(2):
+            grads = [torch.ones_like(p) * (self.rank + step) for p in params]
+            # in backward order, parameter 3 gets no gradient
+            for i in (4, 2, 1, 0):
+                scheduler.mark_ready(i, grads[i])
+            scheduler.flush()
+            for b in range(scheduler.num_buckets):
+                for i in scheduler.wait_bucket(b):
+                    if i != 3:
+                        expected = sum(range(self.world_size)) / self.world_size + step
+                        self.assertEqual(grads[i], torch.ones_like(grads[i]) * expected)
+            scheduler.reset()
+
+    def test_inflight_limits(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        pg._set_inflight_limits(max_ops=2, max_bytes=1 << 20)
+
+        tensors = [torch.ones(1024) * (self.rank + 1) for _ in range(16)]
+        works = [pg.allreduce([t]) for t in tensors]
+        for work in works:
+            work.wait()
+        expected = torch.ones(1024) * sum(range(1, self.world_size + 1))
+        for t in tensors:
+            self.assertEqual(t, expected)
+
+        stats = pg._get_inflight_stats()
+        self.assertEqual(stats["inflight_ops"], 0)
+        self.assertEqual(stats["inflight_bytes"], 0)
+        pg._set_inflight_limits(0, 0)
+
+    def test_local_bootstrap(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        pg._set_local_bootstrap(os.path.basename(self.file_name))
+
+        t = torch.ones(16) * (self.rank + 1)
+        pg.allreduce([t]).wait()
+        self.assertEqual(t, torch.ones(16) * sum(range(1, self.world_size + 1)))
+        with self.assertRaisesRegex(RuntimeError, "before the first collective"):
+            pg._set_local_bootstrap("late")
+
+    def test_shared_communicators(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pgs = [c10d.ProcessGroupCCL(c10d.PrefixStore(str(i), store), self.rank, self.world_size)
+               for i in range(3)]
+        for pg in pgs:
+            pg._set_comm_share_key("world")
+
+        for i, pg in enumerate(pgs):
+            t = torch.ones(16) * (i + 1)
+            pg.allreduce([t]).wait()
+            self.assertEqual(t, torch.ones(16) * (i + 1) * self.world_size)
+        self.assertEqual(oneccl_bindings_for_pytorch.ccl_lib._shared_comms_count(), 1)
+
+    def test_abort_and_rebuild(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+        pg.allreduce([torch.ones(16)]).wait()
+
+        pg._abort()
+        self.assertTrue(pg._is_aborted())
+        with self.assertRaisesRegex(RuntimeError, "aborted"):
+            pg.allreduce([torch.ones(16)])
+
+        prefix_store = c10d.PrefixStore("rebuild", store)
+        new_pg = c10d.ProcessGroupCCL(prefix_store, self.rank, self.world_size)
+        t = torch.ones(16)
+        new_pg.allreduce([t]).wait()
+        self.assertEqual(t, torch.ones(16) * self.world_size)
+
+    def test_work_timing(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+
+        work = pg.allreduce([torch.ones(1024)])
+        work.wait()
+        timing = oneccl_bindings_for_pytorch.ccl_lib._get_work_timing(work)
+        self.assertTrue(0 < timing["enqueue_ns"] <= timing["start_ns"] <= timing["end_ns"])
+        self.assertAlmostEqual(timing["total_ms"], timing["queue_ms"] + timing["transfer_ms"], places=3)
+
+    def test_reduce_scatter_base_upcast(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupCCL(store, self.rank, self.world_size)
+
+        # bf16 gradients reduced into a fp32 shard with fp32 accumulation.
+        # Every value is exact in bf16, but bf16 steps by 2 around 256, so only
+        # a fp32 accumulation keeps the fractions of the sum.
+        value = 2.0 ** 8 if self.rank == 0 else 2.0 ** -self.rank
+        input_t = torch.full([4 * self.world_size], value, dtype=torch.bfloat16)
+        output_t = torch.empty([4], dtype=torch.float)
+        pg._reduce_scatter_base(output_t, input_t).wait()
+
+        expected = torch.full([4], 2.0 ** 8 + sum(2.0 ** -r for r in range(1, self.world_size)))
+        self.assertNotEqual(expected, expected.bfloat16().float())
+        self.assertEqual(output_t, expected)
         
     def _test_reduce_scatter_ops(self, fn):
         store = c10d.FileStore(self.file_name, self.world_size)